@@ -7,11 +7,22 @@
 #   define NOMINMAX
 #   include <Windows.h>
 #else
+#   include <unistd.h>
+#   include <fcntl.h>
+#   include <errno.h>
+#   include <poll.h>
+#   include <termios.h>
+#   include <signal.h>
+#   include <pthread.h>
+#   include <atomic>
 #endif
 #include <stdlib.h>
 #include <string.h>
 #include <stdio.h>
 #include <time.h>
+#if defined(__SSE2__) || defined(_M_X64)
+#   include <emmintrin.h>
+#endif
 #pragma endregion
 
 #pragma region Constants
@@ -53,10 +64,58 @@ typedef unsigned char           byte;
 #pragma region Structs, Other Typedefs
 
 typedef bool (*compare_callback)(void *a, void *b);
+typedef bool (*predicate_callback)(void *object, void *user_data);
+typedef u64 (*hash_callback)(void *key);
+typedef bool (*equals_callback)(void *a, void *b);
+
+// what an allocation is for, each has its own allocator and statistics
+typedef enum
+{
+    alloc_array,            // arrays that belong to none of the others
+    alloc_string,
+    alloc_hashmap,
+    alloc_pool,
+    alloc_arena,
+    alloc_screen,
+    alloc_input,
+    alloc_general,          // SAFEDELETE and everything else
+    alloc_subsystem_count
+} ik_alloc_subsystem;
+
+typedef struct
+{
+  void *(*allocate)(void *context, u64 size);
+  void *(*reallocate)(void *context, void *memory, u64 old_size, u64 size);
+  void (*deallocate)(void *context, void *memory, u64 size);
+  void *context;
+} ik_allocator;
+
+typedef struct
+{
+  u64 allocs;
+  u64 reallocs;
+  u64 frees;
+  u64 bytes;                // requested by allocs and reallocs
+} ik_alloc_stats;
+
+typedef struct
+{
+  byte *chunk;              // the current chunk, it starts with a link to the one before
+  u64 used;                 // bytes of the current chunk in use
+  u64 chunk_size;
+  u64 default_chunk_size;
+} ik_arena;
+
+typedef struct
+{
+  byte *chunk;
+  u64 used;
+} ik_arena_mark;
 
 typedef struct {
   char *cstring;
   u64 size;
+  ik_arena *arena;          // where cstring lives, null for the heap
 } ik_string;
 
 typedef struct
@@ -65,8 +124,39 @@ typedef struct
   u64 stride;
   u64 size;
   u64 capacity;
+  ik_arena *arena;          // where data lives, null for the heap
+  ik_alloc_subsystem subsystem;
 } ik_array;
 
+typedef struct
+{
+  byte *control;            // a byte per slot: empty, deleted or 7 bits of the key's hash
+  byte *slots;              // the keys, each followed by its value
+  u64 key_stride;
+  u64 value_stride;
+  u64 value_offset;
+  u64 slot_stride;
+  u64 size;
+  u64 capacity;
+  u64 growth_left;          // empty slots that may still be taken before it grows
+  hash_callback hash;
+  equals_callback equals;
+} ik_hashmap;
+
+typedef ik_hashmap ik_hashset;
+
+typedef struct
+{
+  ik_array blocks;          // the blocks, each aligned to block_size and starting with a bit per live slot
+  byte *free_list;          // the first free slot, each free slot holds the next one
+  u64 stride;
+  u64 slot_stride;
+  u64 block_size;
+  u64 objects_per_block;
+  u64 slot_offset;          // where the slots of a block begin
+  u64 size;
+} ik_pool;
+
 typedef struct
 {
     u32 state_array[624];
@@ -100,6 +190,23 @@ typedef enum{
     white,
 } color;
 
+/**
+ * @brief a cell color: one of the basic color values, a 256-color palette index or 24-bit RGB
+ * @note basic colors convert implicitly, use ik_color_256() and ik_rgb() for the others
+ */
+typedef u32 ik_color;
+
+#define IK_COLOR_TAG_256 0x01000000u
+#define IK_COLOR_TAG_RGB 0x02000000u
+#define ik_color_256(index) ((ik_color)(IK_COLOR_TAG_256 | (u8)(index)))
+#define ik_rgb(r, g, b) ((ik_color)(IK_COLOR_TAG_RGB | ((u32)(u8)(r) << 16) | ((u32)(u8)(g) << 8) | (u32)(u8)(b)))
+
+typedef enum {
+    color_mode_16,
+    color_mode_256,
+    color_mode_truecolor
+} ik_color_mode;
+
 
 
 
@@ -111,6 +218,30 @@ typedef struct {
     color _background;
 } pixel;
 
+/**
+ * @brief byte-packed variant of pixel for batch submission
+ * @note _glyph is a plain character or an id from ik_glyph_intern()
+ * @note _foreground and _background hold basic color values
+ */
+typedef struct {
+    u8 _x;
+    u8 _y;
+    u16 _glyph;
+    u8 _foreground;
+    u8 _background;
+} compact_pixel;
+
+/**
+ * @brief a single cell of the screen framebuffer
+ * @note ids below 256 are single bytes printed as they are, everything else
+ * points into the interned glyph table. See ik_glyph_intern()
+ */
+typedef struct {
+    u16 _glyph;
+    ik_color _foreground;
+    ik_color _background;
+} ik_cell;
+
 #pragma endregion
 
 #pragma region Clear Screen Logic
@@ -128,12 +259,41 @@ typedef struct {
 #define SAFEDELETE(x)   \
 if (x != 0)             \
 {                       \
-    free(x);            \
+    ik_free(alloc_general, x, 0); \
     x = 0;              \
 }
 
 #pragma endregion
 
+#pragma region Allocator
+
+/**
+ * @brief sets the allocator a subsystem takes its memory from
+ * @param[in] subsystem the subsystem
+ * @param[in] allocator the allocator, null for malloc, realloc and free
+ * @note Set it before the subsystem allocates anything, memory is given back to the allocator in use then.
+ */
+extern void ik_set_allocator(ik_alloc_subsystem subsystem, const ik_allocator* allocator);
+extern ik_allocator ik_get_allocator(ik_alloc_subsystem subsystem);
+
+/**
+ * @brief allocate, resize and free memory through the allocator of a subsystem and count it
+ * @param[in] subsystem the subsystem the memory is for
+ * @param[in] old_size,size the size in bytes, the size a block is freed with may be 0 if it is not known
+ */
+extern void* ik_alloc(ik_alloc_subsystem subsystem, u64 size);
+extern void* ik_realloc(ik_alloc_subsystem subsystem, void* memory, u64 old_size, u64 size);
+extern void ik_free(ik_alloc_subsystem subsystem, void* memory, u64 size);
+
+/**
+ * @brief the allocations of a subsystem since the start or the last ik_reset_alloc_stats()
+ * @param[in] subsystem the subsystem
+ */
+extern ik_alloc_stats ik_get_alloc_stats(ik_alloc_subsystem subsystem);
+extern void ik_reset_alloc_stats();
+
+#pragma endregion
+
 #pragma region Math
 
 /**
@@ -214,6 +374,62 @@ typedef void(*measure_callback)(void*);
 extern void ik_measure_time (char* name, void* params, measure_callback cb);
 #pragma endregion
 
+#pragma region Arena
+
+/**
+ * @brief Creates a bump allocator, memory is taken from chunks and given back all at once
+ * @param[in,out] arena the arena to be managed
+ * @param[in] chunk_size the size of a chunk, larger allocations get a chunk of their own
+ * @note The first chunk is allocated with the first allocation. Call ik_arena_destroy() at the end of its life-time.
+ */
+extern void ik_arena_make(ik_arena* arena, u64 chunk_size);
+
+/**
+ * @brief Frees every chunk of the arena
+ * @param[in,out] arena the arena to be destroyed
+ */
+extern void ik_arena_destroy(ik_arena* arena);
+
+/**
+ * @brief Allocates memory from the arena, aligned to 16 bytes and not initialized
+ * @param[in,out] arena the arena
+ * @param[in] size the number of bytes
+ * @returns the memory, null if a new chunk could not be allocated
+ * @note the memory is not freed on its own, it is given back by ik_arena_reset() or ik_arena_reset_to()
+ */
+extern void* ik_arena_alloc(ik_arena* arena, u64 size);
+
+/**
+ * @brief remembers how much of the arena is in use
+ * @param[in] arena the arena
+ * @returns the mark to be passed to ik_arena_reset_to()
+ */
+extern ik_arena_mark ik_arena_get_mark(ik_arena* arena);
+
+/**
+ * @brief gives back everything allocated since a mark was taken
+ * @param[in,out] arena the arena
+ * @param[in] mark a mark of this arena, marks taken after it are invalid afterwards
+ */
+extern void ik_arena_reset_to(ik_arena* arena, ik_arena_mark mark);
+
+/**
+ * @brief gives back everything allocated from the arena
+ * @param[in,out] arena the arena
+ * @note O(1) if everything fit into one chunk. Otherwise the chunks are replaced by one that fits
+ * all of them, so the next round of the same allocations does not need another.
+ */
+extern void ik_arena_reset(ik_arena* arena);
+
+/**
+ * @brief an allocator that takes memory from an arena, for ik_set_allocator()
+ * @param[in] arena the arena, it has to outlive everything allocated through the allocator
+ * @note Freeing does nothing, reallocating grows the last allocation in place when it can.
+ */
+extern ik_allocator ik_arena_allocator(ik_arena* arena);
+
+#pragma endregion
+
 #pragma region String
 
 typedef enum {
@@ -250,6 +466,17 @@ extern void ik_string_make(ik_string* string, const char* cstring);
  */
 extern void ik_string_make_empty(ik_string* string, u64 charcount);
 
+/**
+ * @brief the same as ik_string_make(), ik_string_make_empty() and ik_string_make_range(), with the
+ * characters in an arena. A null arena uses the heap.
+ * @param[in,out] arena the arena the string lives in
+ * @note Strings an arena string is changed into stay in its arena. ik_string_destroy() does not free
+ * them, they are given back with the arena.
+ */
+extern void ik_string_make_arena(ik_string* string, const char* cstring, ik_arena* arena);
+extern void ik_string_make_empty_arena(ik_string* string, u64 charcount, ik_arena* arena);
+extern void ik_string_make_range_arena(ik_string* string, const char* cstring, u64 start, u64 end, ik_arena* arena);
+
 /**
  * @brief Creates two strings which are split at the first occurence of the delimiter
  * @param[in] string the string object to be created
@@ -384,6 +611,7 @@ extern void ik_print_string(ik_string *in, reserve_space_options reserve, int sp
 * @param[in] max_len maximum length of the input
 * @param[in] type specify which type the input should match
 * @param[in] return_code 1 if successful, 2 if input is to long, 3 if type missmatch
+* @note blocks until enter is pressed, inside a game loop use an ik_line_editor instead
 */
 extern bool ik_read_string(ik_string* string, int max_len, type_options type, int* return_code);
 
@@ -425,6 +653,14 @@ typedef enum
  */
 extern void ik_array_make(ik_array *ik_array, u64 stride_size, u64 num_elements);
 
+/**
+ * @brief the same as ik_array_make(), with the elements in an arena. A null arena uses the heap.
+ * @param[in,out] arena the arena the elements live in
+ * @note Growing takes a new block from the arena unless the array is the last thing allocated from it.
+ * ik_array_destroy() does not free the memory, it is given back with the arena.
+ */
+extern void ik_array_make_arena(ik_array* ik_array, u64 stride_size, u64 num_elements, ik_arena* arena);
+
 /**
  * @brief Destroys the data from a given array.
  * @param[in,out] array is the array to be destroyed
@@ -435,10 +671,29 @@ extern void ik_array_destroy(ik_array* ik_array);
  * @brief Appends to the given array another element.
  * @param[in,out] array is the array to append to
  * @param[in] object is the array to append to
- * @note If there's no more memory available within the array, it grows linearily by 10 elements.
+ * @note If there's no more memory available within the array, its capacity doubles, so appending is amortized O(1).
  */
 extern void ik_array_append(ik_array* thisptr, void* object);
 
+/**
+ * @brief Inserts an element, the elements from index on move up one place
+ * @param[in,out] thisptr the array to insert into
+ * @param[in] index where the element goes, size appends it
+ * @param[in] object the element to copy in, must not point into the array
+ * @returns false if the index is past the end or the memory could not be allocated
+ */
+extern bool ik_array_insert(ik_array* thisptr, u64 index, void* object);
+
+/**
+ * @brief Inserts count elements in one move
+ * @param[in,out] thisptr the array to insert into
+ * @param[in] index where the first element goes, size appends them
+ * @param[in] objects the elements to copy in, must not point into the array
+ * @param[in] count the number of elements
+ * @returns false if the index is past the end or the memory could not be allocated
+ */
+extern bool ik_array_insert_range(ik_array* thisptr, u64 index, void* objects, u64 count);
+
 /**
  * @brief Removes an element from the given array
  * @param[in,out] array the array to remove an element from
@@ -447,22 +702,51 @@ extern void ik_array_append(ik_array* thisptr, void* object);
  */
 extern void ik_array_remove(ik_array* thisptr, u32 index);
 
+/**
+ * @brief Removes count elements in one move, the elements after them keep their order
+ * @param[in,out] thisptr the array to remove the elements from
+ * @param[in] index the index of the first element to be removed
+ * @param[in] count the number of elements, cut off at the end of the array
+ */
+extern void ik_array_remove_range(ik_array* thisptr, u64 index, u64 count);
+
 /**
  * @brief Removes an element from the given array quickly
  * @param[in,out] array the array to remove an element from
  * @param[in] index the index of the element to be removed
- * @note O(1) constant removal. Use when performance matters but order does not.
+ * @note O(1) constant removal, the last element takes its place. Use when performance matters but order does not.
  */
 extern void ik_array_remove_fast(ik_array* thisptr, u32 index);
 
 /**
- * @brief Sorts an array using bubble sort and a sorting mode
+ * @brief Removes every element a predicate is true for, the rest keep their order
+ * @param[in,out] thisptr the array
+ * @param[in] predicate called with each element and user_data, returns true to remove it
+ * @param[in] user_data passed on to the predicate
+ * @returns the number of removed elements
+ * @note O(n), the predicate is called once per element and each element that stays is moved at most once
+ */
+extern u64 ik_array_erase_if(ik_array* thisptr, predicate_callback predicate, void* user_data);
+
+/**
+ * @brief Sorts an array using introsort and a sorting mode
  * @param[in,out] array the array to be sorted
+ * @param[in] comparator returns true if a is greater than b, like the ik_compare functions
  * @param[in] mode is the mode of sorting (ascending or descending)
- * @note O(n*n) squared time sorting at worst.
+ * @note O(n log n) at worst. Equal elements may change their order, use ik_array_sort_stable() to keep it.
+ * @note arrays of the type a built-in ik_compare function is for are radix sorted without calling it
  */
 extern void ik_array_sort(ik_array* thisptr, compare_callback comparator, ik_array_sort_mode mode);
 
+/**
+ * @brief Sorts an array using mergesort and a sorting mode, equal elements keep their order
+ * @param[in,out] array the array to be sorted
+ * @param[in] comparator returns true if a is greater than b, like the ik_compare functions
+ * @param[in] mode is the mode of sorting (ascending or descending)
+ * @note O(n log n) at worst. Needs a buffer of half the array, which is kept for the next call.
+ */
+extern void ik_array_sort_stable(ik_array* thisptr, compare_callback comparator, ik_array_sort_mode mode);
+
 /**
  * @brief grows the array's capacity by allocating more memory to the array
  * @param[in,out] thisptr the array to grow
@@ -470,6 +754,29 @@ extern void ik_array_sort(ik_array* thisptr, compare_callback comparator, ik_arr
  */
 extern void ik_array_grow(ik_array * thisptr, u64 size);
 
+/**
+ * @brief makes sure the array can hold a number of elements without reallocating
+ * @param[in,out] thisptr the array
+ * @param[in] capacity the number of elements
+ * @returns false if the memory could not be allocated
+ * @note pointers into the array are invalid afterwards if it had to grow
+ */
+extern bool ik_array_reserve(ik_array* thisptr, u64 capacity);
+
+/**
+ * @brief releases the capacity the array does not use
+ * @param[in,out] thisptr the array
+ */
+extern void ik_array_shrink_to_fit(ik_array* thisptr);
+
+/**
+ * @brief sets the number of elements, new elements are zeroed
+ * @param[in,out] thisptr the array
+ * @param[in] size the new number of elements
+ * @returns false if the memory could not be allocated
+ */
+extern bool ik_array_resize(ik_array* thisptr, u64 size);
+
 /**
  * @brief Gets an element from the array
  * @param[in,out] array the array to be sorted
@@ -489,11 +796,240 @@ extern void ik_swap(void *src, void *dst, u64 size);
 * @brief checks if an array contains a specific object
  * @param[in] thisptr the array to check
  * @param[in] object the object to find
- * @param[in] comparator the comparison function
+ * @param[in] comparator the comparison function, null compares the bytes
  * @returns true if the object is found, false if not
+ * @note O(n), use ik_array_binary_search() on sorted arrays. Without a comparator arrays with a stride
+ * of 1, 2, 4, 8 or 16 bytes are scanned 16 bytes at a time
  */
 extern bool ik_array_contains(ik_array* thisptr, void* object, compare_callback comparator);
 
+/**
+ * @brief finds the first element matching an object, like ik_array_contains()
+ * @param[in] thisptr the array to search
+ * @param[in] object the object to find
+ * @param[in] comparator the comparison function, null compares the bytes
+ * @returns the index of the element, -1 if there is none
+ */
+extern i64 ik_array_find_index(ik_array* thisptr, void* object, compare_callback comparator);
+
+/**
+ * @brief counts the elements matching an object, like ik_array_contains()
+ * @param[in] thisptr the array to search
+ * @param[in] object the object to count
+ * @param[in] comparator the comparison function, null compares the bytes
+ * @returns the number of matching elements
+ */
+extern u64 ik_array_count(ik_array* thisptr, void* object, compare_callback comparator);
+
+/**
+ * @brief finds the first element of a sorted array that does not go before an object
+ * @param[in] thisptr the array, sorted by comparator and mode
+ * @param[in] object the object to look for
+ * @param[in] comparator returns true if a is greater than b, like the ik_compare functions
+ * @param[in] mode the order the array is sorted in
+ * @returns the index of the element, size if there is none
+ * @note O(log n)
+ */
+extern u64 ik_array_lower_bound(ik_array* thisptr, void* object, compare_callback comparator, ik_array_sort_mode mode);
+
+/**
+ * @brief finds the first element of a sorted array that goes after an object
+ * @param[in] thisptr the array, sorted by comparator and mode
+ * @param[in] object the object to look for
+ * @param[in] comparator returns true if a is greater than b, like the ik_compare functions
+ * @param[in] mode the order the array is sorted in
+ * @returns the index of the element, size if there is none
+ * @note O(log n)
+ */
+extern u64 ik_array_upper_bound(ik_array* thisptr, void* object, compare_callback comparator, ik_array_sort_mode mode);
+
+/**
+ * @brief finds an element equal to an object in a sorted array
+ * @param[in] thisptr the array, sorted by comparator and mode
+ * @param[in] object the object to look for
+ * @param[in] comparator returns true if a is greater than b, like the ik_compare functions
+ * @param[in] mode the order the array is sorted in
+ * @returns the index of the first equal element, -1 if there is none
+ * @note O(log n)
+ */
+extern i64 ik_array_binary_search(ik_array* thisptr, void* object, compare_callback comparator, ik_array_sort_mode mode);
+
+/**
+ * @brief inserts an element into a sorted array where it keeps the array sorted, after equal elements
+ * @param[in,out] thisptr the array, sorted by comparator and mode
+ * @param[in] object the element to copy in, must not point into the array
+ * @param[in] comparator returns true if a is greater than b, like the ik_compare functions
+ * @param[in] mode the order the array is sorted in
+ * @returns false if the memory could not be allocated
+ * @note O(log n) to find the place, O(n) to move the elements after it
+ */
+extern bool ik_array_insert_sorted(ik_array* thisptr, void* object, compare_callback comparator, ik_array_sort_mode mode);
+
+/**
+ * @brief merges two sorted arrays and appends the result to another one
+ * @param[in,out] out receives the elements, has to have the same stride and be neither a nor b
+ * @param[in] a the first array, its elements go before equal ones of b
+ * @param[in] b the second array
+ * @param[in] comparator returns true if a is greater than b, like the ik_compare functions
+ * @param[in] mode the order both arrays are sorted in
+ * @returns false if the strides differ or the memory could not be allocated
+ * @note O(n + m)
+ */
+extern bool ik_array_merge(ik_array* out, ik_array* a, ik_array* b, compare_callback comparator, ik_array_sort_mode mode);
+
+#pragma endregion
+
+#pragma region Hash Map
+
+/**
+ * @brief Creates a hash map, keys and values are copied in like array elements
+ * @param[in,out] map the map to be managed
+ * @param[in] key_stride the size of a key
+ * @param[in] value_stride the size of a value, 0 for a set
+ * @param[in] num_elements the number of elements it should hold without growing
+ * @param[in] hash hashes a key, null hashes its bytes
+ * @param[in] equals returns true if two keys are equal, null compares their bytes
+ * @note Open addressing in one flat block. Lookups compare the hash bytes of 16 slots at a time.
+ * Call ik_hashmap_destroy to free mem at the end of its life-time.
+ */
+extern void ik_hashmap_make(ik_hashmap* map, u64 key_stride, u64 value_stride, u64 num_elements, hash_callback hash, equals_callback equals);
+
+/**
+ * @brief Destroys the data of a map
+ * @param[in,out] map the map to be destroyed
+ */
+extern void ik_hashmap_destroy(ik_hashmap* map);
+
+/**
+ * @brief Inserts a key or sets the value of a key that is already in the map
+ * @param[in,out] map the map
+ * @param[in] key the key to copy in
+ * @param[in] value the value to copy in, null leaves it zeroed for a new key and unchanged otherwise
+ * @returns the value in the map, null if the memory could not be allocated
+ * @note pointers into the map are invalid afterwards if it had to grow
+ */
+extern void* ik_hashmap_insert(ik_hashmap* map, void* key, void* value);
+
+/**
+ * @brief Finds the value of a key
+ * @param[in] map the map
+ * @param[in] key the key to look for
+ * @returns the value in the map, null if the key is not in it
+ */
+extern void* ik_hashmap_get(ik_hashmap* map, void* key);
+extern bool ik_hashmap_contains(ik_hashmap* map, void* key);
+
+/**
+ * @brief Removes a key and its value
+ * @param[in,out] map the map
+ * @param[in] key the key to remove
+ * @returns false if the key was not in the map
+ */
+extern bool ik_hashmap_remove(ik_hashmap* map, void* key);
+
+/**
+ * @brief Removes every key, the memory is kept
+ * @param[in,out] map the map
+ */
+extern void ik_hashmap_clear(ik_hashmap* map);
+
+/**
+ * @brief makes sure the map can hold a number of elements without growing
+ * @param[in,out] map the map
+ * @param[in] count the number of elements
+ * @returns false if the memory could not be allocated
+ */
+extern bool ik_hashmap_reserve(ik_hashmap* map, u64 count);
+
+/**
+ * @brief walks over the elements of a map in no particular order
+ * @param[in] map the map
+ * @param[in,out] iterator 0 for the first call, then passed back unchanged
+ * @param[out] key receives the key, may be null
+ * @param[out] value receives the value, may be null
+ * @returns false when there are no more elements
+ * @note the map must not be changed while walking over it, except for ik_hashmap_remove() on the current key
+ */
+extern bool ik_hashmap_next(ik_hashmap* map, u64* iterator, void** key, void** value);
+
+/**
+ * @brief the same as the hash map functions, for a map without values
+ * @note ik_hashset_insert returns false if the key was in the set already or the memory could not be allocated
+ */
+extern void ik_hashset_make(ik_hashset* set, u64 key_stride, u64 num_elements, hash_callback hash, equals_callback equals);
+extern void ik_hashset_destroy(ik_hashset* set);
+extern bool ik_hashset_insert(ik_hashset* set, void* key);
+extern bool ik_hashset_contains(ik_hashset* set, void* key);
+extern bool ik_hashset_remove(ik_hashset* set, void* key);
+extern void ik_hashset_clear(ik_hashset* set);
+extern bool ik_hashset_next(ik_hashset* set, u64* iterator, void** key);
+
+/**
+ * @brief hashes a block of memory, 8 bytes at a time
+ * @param[in] data the memory
+ * @param[in] size its size in bytes
+ * @returns a 64-bit hash
+ */
+extern u64 ik_hash_bytes(const void* data, u64 size);
+
+/**
+ * @brief hash and equality for ik_string keys, they hash and compare the characters
+ * @param[in] key an ik_string
+ */
+extern u64 ik_hash_string(void* key);
+extern bool ik_equals_string(void* a, void* b);
+
+#pragma endregion
+
+#pragma region Pool
+
+/**
+ * @brief Creates a pool of same-sized objects that keep their address until they are freed
+ * @param[in,out] pool the pool to be managed
+ * @param[in] stride the size of an object
+ * @param[in] objects_per_block how many objects are allocated at once, it rounds up to fill the block
+ * @note Call ik_pool_destroy to free mem at the end of its life-time.
+ */
+extern void ik_pool_make(ik_pool* pool, u64 stride, u64 objects_per_block);
+
+/**
+ * @brief Frees every block of the pool, and with them every object
+ * @param[in,out] pool the pool to be destroyed
+ */
+extern void ik_pool_destroy(ik_pool* pool);
+
+/**
+ * @brief takes a zeroed object from the pool
+ * @param[in,out] pool the pool
+ * @returns the object, null if a new block could not be allocated
+ * @note O(1), freed objects are handed out again before a new block is allocated
+ */
+extern void* ik_pool_alloc(ik_pool* pool);
+
+/**
+ * @brief gives an object back to the pool
+ * @param[in,out] pool the pool the object was taken from
+ * @param[in] object the object, freeing it a second time does nothing
+ * @note O(1)
+ */
+extern void ik_pool_free(ik_pool* pool, void* object);
+
+/**
+ * @brief gives every object back to the pool, the blocks are kept
+ * @param[in,out] pool the pool
+ */
+extern void ik_pool_clear(ik_pool* pool);
+
+/**
+ * @brief walks over the live objects of a pool in address order within each block
+ * @param[in] pool the pool
+ * @param[in,out] iterator 0 for the first call, then passed back unchanged
+ * @param[out] object receives the object
+ * @returns false when there are no more objects
+ * @note objects may be freed while walking, objects allocated meanwhile may or may not be visited
+ */
+extern bool ik_pool_next(ik_pool* pool, u64* iterator, void** object);
+
 #pragma endregion
 
 #pragma region Parser
@@ -713,9 +1249,153 @@ extern ik_array SCREEN_BUFFER;
 extern bool SCREEN_UPDATE;
 extern int TICKRATE;
 
-extern void ik_screen_init(u8 width, u8 height, char background, int mx_tick_rate);
+extern void ik_screen_init(u8 width, u8 height, char background, int max_tick_rate);
 extern void ik_screen_set_pixels(ik_array pixels);
-extern void ik_screen_set_pixel(u8 x, u8 y, char to, color foreground, color background);
+
+/**
+ * @brief writes a batch of pixels straight into the framebuffer
+ * @param[in] pixels pointer to the first pixel of the batch
+ * @param[in] count the number of pixels in the batch
+ * @note pixels outside the screen or set to IK_GLYPH_WIDE_TAIL are dropped, glyph ids that were never
+ * interned print as '?'. Later pixels win if several hit the same cell.
+ */
+extern void ik_screen_set_pixel_span(const compact_pixel* pixels, u64 count);
+extern void ik_screen_set_pixel(u8 x, u8 y, char to, ik_color foreground, ik_color background);
+
+/**
+ * @brief marks the right half of a double-width glyph, the cell to its left holds the glyph
+ */
+#define IK_GLYPH_WIDE_TAIL ((u16)0xFFFF)
+
+/**
+ * @brief interns the first UTF-8 character of a string into the glyph table
+ * @param[in] utf8 the UTF-8 encoded character, trailing combining marks are kept with it
+ * @returns the glyph id, ASCII characters map to themselves, invalid or unstorable input to '?'
+ * @note interning the same character twice returns the same id
+ */
+extern u16 ik_glyph_intern(const char* utf8);
+
+/**
+ * @brief gets the amount of screen columns a glyph covers
+ * @param[in] glyph the glyph id
+ * @returns 1 or 2, 0 for IK_GLYPH_WIDE_TAIL
+ */
+extern u8 ik_glyph_width(u16 glyph);
+
+/**
+ * @brief sets a cell to an interned glyph
+ * @param[in] x the column, a double-width glyph also covers x + 1
+ * @param[in] y the row
+ * @param[in] glyph the glyph id
+ * @note a double-width glyph that does not fit into the last column is replaced by a space, an id that
+ * was never interned by '?'. IK_GLYPH_WIDE_TAIL is ignored.
+ */
+extern void ik_screen_set_glyph(u8 x, u8 y, u16 glyph, ik_color foreground, ik_color background);
+
+/**
+ * @brief writes a UTF-8 string into a row of the screen
+ * @param[in] x the starting column
+ * @param[in] y the row
+ * @param[in] utf8 the UTF-8 encoded text
+ * @returns the amount of columns written
+ * @note the text is cut at the right edge of the screen
+ */
+extern u32 ik_screen_set_text(u8 x, u8 y, const char* utf8, ik_color foreground, ik_color background);
+
+typedef struct {
+    u64 frames;             /**< frames written to the terminal */
+    u64 frame_bytes;        /**< bytes of the last frame */
+    u64 output_rate;        /**< smoothed terminal throughput in bytes per second */
+    u64 color_downgrades;   /**< times the adaptive color mode stepped down */
+    u64 frames_over_budget; /**< ticks that took longer than 1000 / TICKRATE milliseconds */
+    u64 frames_skipped;     /**< ticks that were not presented to save output time */
+    u64 frames_diffed;      /**< frames that only wrote the cells that changed */
+    u64 quality_changes;    /**< times the frame budget controller changed the quality level */
+    u32 quality_level;      /**< 0 is full quality, then diff-only output, 256 colors, 16 colors, skipping every other frame, skipping two of three frames */
+    u64 frames_merged;      /**< queued frames that were replaced by a newer one before being written */
+    u64 pending_bytes;      /**< bytes still waiting for the terminal */
+} ik_screen_stats;
+
+/**
+ * @brief sets how colors are written to the terminal for this session
+ * @param[in] mode the richest color mode to use, richer cell colors are mapped down to it
+ * @param[in] adaptive if true, the mode steps down while writing frames takes up most of
+ * the frame time and back up once the link has been calm for a while
+ */
+extern void ik_screen_set_color_mode(ik_color_mode mode, bool adaptive);
+
+/**
+ * @brief gets the color mode frames are currently written with
+ */
+extern ik_color_mode ik_screen_get_color_mode();
+
+/**
+ * @brief turns the frame budget controller on or off, it is on by default
+ * @param[in] enabled if true, ticks that run over 1000 / TICKRATE milliseconds step by step
+ * switch to diff-only output, lower the color depth and skip presenting frames until they fit
+ * again. Input and simulation keep running at the full tick rate.
+ * @note how often this happens is reported by ik_screen_get_stats()
+ */
+extern void ik_screen_set_adaptive_quality(bool enabled);
+
+/**
+ * @brief checks if the terminal could not take the last frame completely
+ * @returns true while frames wait for the terminal
+ * @note (NOT ON WINDOWS) frames are written to a non-blocking descriptor of the terminal and a
+ * slow link never blocks ik_screen_print(). A frame that has not started writing yet is replaced by
+ * the next one, so at most one frame is ever waiting. When stdout is not a terminal frames are
+ * written through stdout and this is always false.
+ */
+extern bool ik_screen_output_congested();
+
+/**
+ * @brief gets the output statistics of the screen
+ * @param[out] out the statistics
+ */
+extern void ik_screen_get_stats(ik_screen_stats* out);
+
+typedef enum {
+    latency_total,      /**< from the input event to the last byte of the first frame that shows it */
+    latency_input,      /**< from the input event to the ik_update_input() call that takes it */
+    latency_logic,      /**< from that ik_update_input() call to the ik_screen_print() that presents it */
+    latency_output      /**< from that ik_screen_print() call until the terminal took the whole frame */
+} ik_latency_stage;
+
+typedef struct {
+    u64 samples;
+    i64 min_us;
+    i64 max_us;
+    i64 mean_us;
+    i64 p50_us;
+    i64 p90_us;
+    i64 p99_us;
+    i64 p999_us;
+} ik_latency_stats;
+
+/**
+ * @brief gets how long input takes to show up on the screen
+ * @param[in] stage the part of the way to measure
+ * @param[out] out the statistics
+ * @note every input event is a sample. The percentiles come from a histogram with eight buckets per
+ * power of two, so they are exact up to 12.5 percent
+ */
+extern void ik_screen_get_latency(ik_latency_stage stage, ik_latency_stats* out);
+
+/**
+ * @brief gets a percentile of the input latency
+ * @param[in] stage the part of the way to measure
+ * @param[in] percentile from 0 to 100
+ * @returns the latency in microseconds, 0 without samples
+ */
+extern i64 ik_screen_latency_percentile(ik_latency_stage stage, double percentile);
+extern void ik_screen_reset_latency();
+
+/**
+ * @brief turns headless mode on or off, call it before ik_screen_init()
+ * @param[in] enabled if true, ik_screen_print() still builds every frame but writes nothing and
+ * never waits for the next tick, so a replay runs as fast as the game logic allows
+ */
+extern void ik_screen_set_headless(bool enabled);
 extern void ik_screen_print();
 extern void ik_screen_clear_screen();
 
@@ -745,6 +1425,38 @@ extern bool ik_compare_byte(void* a, void* b);
  * @param[in] milliseconds the time to sleep in milliseconds
  */
 extern void ik_sleep(i64 milliseconds);
+
+/**
+ * @brief gets a monotonic timestamp
+ * @returns the time in microseconds since an unspecified starting point
+ */
+extern i64 ik_time_now_us();
+
+typedef enum {
+    wait_frame,     /**< the next frame is due, SCREEN_UPDATE is true */
+    wait_input,     /**< there is input for ik_update_input() */
+    wait_fd         /**< a descriptor added with ik_wait_add_fd() is readable */
+} ik_wait_result;
+
+/**
+ * @brief sleeps until the next frame is due or something happens before that, whichever is first
+ * @param[out] ready_fd the readable descriptor for wait_fd, -1 otherwise. May be null
+ * @returns why the wait ended
+ * @note once a program calls this, ik_screen_print() no longer sleeps itself and leaves
+ * SCREEN_UPDATE false until ik_wait() reaches the next frame. Without a tick rate every call returns wait_frame.
+ * @note (LINUX) waits in a single poll() on the terminal, the input thread and the added descriptors
+ * and keeps writing queued frames meanwhile. On windows it sleeps until the frame is due.
+ */
+extern ik_wait_result ik_wait(int* ready_fd);
+
+/**
+ * @brief adds a descriptor that ends ik_wait() when it is readable, e.g. a timerfd or a signalfd
+ * @param[in] fd the descriptor, it is not read by the library
+ * @returns false if it is already added or 16 descriptors are
+ * @note (LINUX) only, returns false on windows
+ */
+extern bool ik_wait_add_fd(int fd);
+extern void ik_wait_remove_fd(int fd);
 #pragma endregion
 
 #pragma region Input
@@ -763,11 +1475,198 @@ typedef enum {
     pressed, held, released
 }ik_key_state;
 
+/**
+* @brief key codes, they match the windows virtual key codes. Digits and
+* letters are their upper case characters, e.g. ik_get_key_state('W', pressed)
+*/
+#define IK_KEY_MOUSE_LEFT   0x01
+#define IK_KEY_MOUSE_RIGHT  0x02
+#define IK_KEY_MOUSE_MIDDLE 0x04
+#define IK_KEY_BACKSPACE    0x08
+#define IK_KEY_TAB          0x09
+#define IK_KEY_ENTER        0x0D
+#define IK_KEY_SHIFT        0x10
+#define IK_KEY_CONTROL      0x11
+#define IK_KEY_ALT          0x12
+#define IK_KEY_ESCAPE       0x1B
+#define IK_KEY_SPACE        0x20
+#define IK_KEY_PAGE_UP      0x21
+#define IK_KEY_PAGE_DOWN    0x22
+#define IK_KEY_END          0x23
+#define IK_KEY_HOME         0x24
+#define IK_KEY_LEFT         0x25
+#define IK_KEY_UP           0x26
+#define IK_KEY_RIGHT        0x27
+#define IK_KEY_DOWN         0x28
+#define IK_KEY_INSERT       0x2D
+#define IK_KEY_DELETE       0x2E
+#define IK_KEY_F1           0x70
+#define IK_KEY_F12          0x7B
+
+typedef enum {
+    key_down, key_up, key_repeat,
+    mouse_move,     /**< the mouse moved to another cell, _key is 0 */
+    mouse_scroll    /**< the wheel turned, _key is IK_KEY_UP or IK_KEY_DOWN */
+}ik_input_event_type;
+
+typedef struct {
+    i64 _time_us;   /**< when the event was seen, see ik_time_now_us() */
+    u32 _char;      /**< the typed character as a unicode codepoint, 0 if the key types none */
+    u8 _key;        /**< the key code, 0 for text that has no key of its own */
+    u8 _type;       /**< an ik_input_event_type */
+    u8 _x, _y;      /**< the SCREEN_BUFFER cell under the mouse when the event happened */
+} ik_input_event;
+
 extern ik_input_type INPUT_TYPE;
 extern void ik_init_input();
+
+/**
+* @brief switches between stream and keyboardhit input
+* @param[in] type the input type
+* @note (LINUX) keyboardhit puts the terminal into cbreak mode without echo, stream and
+* program exit or a terminating signal restore it
+*/
 extern void ik_set_input_type(ik_input_type type);
+
+/**
+* @brief collects the input events since the last call and updates the key states from them, call it once per frame
+* @note a key pressed and released between two updates is still pressed in the first and released in the second
+* @note (LINUX) the terminal has no key release events. A key counts as held while the
+* terminal repeats it and is released once the repeats stop
+* @note with the input thread running this only takes over the events the thread collected
+*/
 extern void ik_update_input();
-extern bool ik_get_key_state(char ch, ik_key_state state);
+extern bool ik_get_key_state(u8 key, ik_key_state state);
+
+/**
+* @brief takes the oldest input event from the queue
+* @param[out] out the event
+* @returns true if there was an event, false if the queue is empty
+* @note the queue holds the last 256 events in the order they happened. Drain it every frame
+* to see presses shorter than a frame and the order of presses within one.
+*/
+extern bool ik_poll_input_event(ik_input_event* out);
+
+/**
+* @brief starts or stops a background thread that waits on the terminal, timestamps keys the
+* moment they arrive and releases them when their repeats stop. ik_update_input() then takes
+* the events over without reading the terminal itself
+* @param[in] enabled true to start the thread, false to stop it
+* @returns true if the thread is running afterwards
+* @note (LINUX) only and only for keyboardhit input, switching to stream stops the thread. On windows
+* the keys are polled and this always returns false
+* @note the thread holds up to 1024 events between two updates. When it is full repeats and mouse moves
+* are dropped, presses and releases reach a later update so the key states end up as without the thread
+*/
+extern bool ik_set_input_thread(bool enabled);
+
+/**
+* @brief turns mouse reporting on or off, call it after ik_screen_init()
+* @param[in] enabled if true, the mouse buttons arrive as key_down and key_up of the IK_KEY_MOUSE keys,
+* the wheel as mouse_scroll and every move as mouse_move, all with the cell under the mouse
+* @returns true if the terminal reports the mouse afterwards
+* @note moves within one update are merged into one event that carries the last cell, so a fast
+* drag costs an event per frame and not one per cell
+* @note (LINUX) only for keyboardhit input, uses xterm SGR reporting. Restored with the terminal at exit.
+* On windows this returns false
+*/
+extern bool ik_set_mouse_input(bool enabled);
+
+/**
+* @brief gets the cell the mouse was last seen over
+* @param[out] x the column
+* @param[out] y the row
+*/
+extern void ik_get_mouse_position(u8* x, u8* y);
+
+/**
+* @brief starts recording the input of every ik_update_input() call to a file
+* @param[in] path the file to write, an existing one is replaced
+* @param[in] seed the seed the game passed to ik_random_init(), a replay hands it back
+* @returns false if the file could not be created
+* @note the recording is finished by ik_input_stop() or at program exit
+*/
+extern bool ik_input_record(const char* path, u32 seed);
+
+/**
+* @brief replays a recording, from now on ik_update_input() feeds the recorded events of each
+* update instead of the keyboard
+* @param[in] path the recording
+* @param[out] seed the seed of the recording, pass it to ik_random_init()
+* @returns false if the file can not be read or is no recording
+* @note the events keep the times of the recording, shifted to the start of the replay. Combined
+* with ik_screen_set_headless() a replay runs as fast as possible
+*/
+extern bool ik_input_replay(const char* path, u32* seed);
+
+/**
+* @brief checks if a replay has reached the update its recording ended with
+* @returns true once the replay is over or if none is running
+*/
+extern bool ik_input_replay_done();
+
+/**
+* @brief compares the game state with the recording, call it once per update with a hash of
+* everything the input drives
+* @param[in] state_hash the hash, any value that is equal for equal states
+* @returns false if a replay reached a different state in this update than the recording did
+* @note while recording the hash is stored with the update, otherwise this always returns true
+*/
+extern bool ik_input_sync(u32 state_hash);
+
+/**
+* @brief finishes a recording or ends a replay
+*/
+extern void ik_input_stop();
+
+#pragma endregion
+
+#pragma region Line Editor
+
+/**
+* @brief a single line text input that is fed with input events and drawn into the screen,
+* unlike ik_read_string() it never blocks the game loop
+*/
+typedef struct {
+    ik_array text;          /**< the line as unicode codepoints (u32) */
+    ik_array history;       /**< the submitted lines as ik_string, oldest first */
+    u32 cursor;             /**< the position in text the next character goes to */
+    u32 scroll;             /**< the first character that is drawn */
+    i32 history_index;      /**< the history line being edited, -1 for a new line */
+    u32 max_len;
+    type_options type;
+} ik_line_editor;
+
+/**
+* @brief creates a line editor
+* @param[in,out] editor the editor to be created
+* @param[in] max_len the most characters a line can have
+* @param[in] type what the line has to be, _int and _float only take digits and one '.' or ','
+* @note call ik_line_editor_destroy() when you're done with it!
+*/
+extern void ik_line_editor_make(ik_line_editor* editor, u32 max_len, type_options type);
+extern void ik_line_editor_destroy(ik_line_editor* editor);
+
+/**
+* @brief applies an input event, typed characters are inserted at the cursor. Left, right, home and end
+* move the cursor, backspace and delete remove, up and down walk the history and escape clears the line
+* @param[in,out] editor the editor
+* @param[in] event the event, e.g. from ik_poll_input_event()
+* @param[out] out receives the line when enter submits it, call ik_string_destroy() on it
+* @param[out] return_code 1 if a line was submitted, 2 if a character did not fit, 3 if the line
+* does not match the type, 0 otherwise. May be null
+* @returns true if a line was submitted
+*/
+extern bool ik_line_editor_feed(ik_line_editor* editor, const ik_input_event* event, ik_string* out, int* return_code);
+
+/**
+* @brief draws the line with its cursor into a row of the screen, scrolled so the cursor stays visible
+* @param[in] editor the editor
+* @param[in] x the first column
+* @param[in] y the row
+* @param[in] width how many columns the line may take
+*/
+extern void ik_line_editor_draw(ik_line_editor* editor, u8 x, u8 y, u8 width, ik_color foreground, ik_color background);
 
 #pragma endregion
 
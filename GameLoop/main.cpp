@@ -16,14 +16,28 @@ int main() {
 	ik_init_input();
 	ik_set_input_type(keyboardhit);
 	
+	u8 x = 0, y = 0;
+
 	//this is the correct syntax for your game loop
 	for (;;) {
-		ik_screen_clear_screen();
+		// sleeps until the next frame is due, a key
+		// press wakes it up right away. nothing runs
+		// in between, so an idle game uses no cpu.
+		ik_wait(0);
+
+		//update the input handler, this also happens
+		//between frames, so keys are handled as soon
+		//as they come in
+		ik_update_input();
+		if (ik_get_key_state(IK_KEY_LEFT, pressed) && x > 0) x--;
+		if (ik_get_key_state(IK_KEY_RIGHT, pressed) && x < SCREEN_WIDTH - 1) x++;
+		if (ik_get_key_state(IK_KEY_UP, pressed) && y > 0) y--;
+		if (ik_get_key_state(IK_KEY_DOWN, pressed) && y < SCREEN_HEIGHT - 1) y++;
+
 		if (SCREEN_UPDATE) {
-			//update the input handler
-			ik_update_input();
+			ik_screen_clear_screen();
 			//set your pixels!
-			ik_screen_set_pixel(0, 0, '#', none, none);
+			ik_screen_set_pixel(x, y, '#', none, none);
 			//print your screen
 			ik_screen_print();
 		}
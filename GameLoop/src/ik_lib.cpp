@@ -4,6 +4,88 @@
 
 #pragma endregion
 
+#pragma region Allocator
+
+void* heap_allocate(void*, u64 size)
+{
+    return malloc(size);
+}
+
+void* heap_reallocate(void*, void* memory, u64, u64 size)
+{
+    return realloc(memory, size);
+}
+
+void heap_deallocate(void*, void* memory, u64)
+{
+    free(memory);
+}
+
+const ik_allocator heap_allocator = { heap_allocate, heap_reallocate, heap_deallocate, 0 };
+
+ik_allocator allocators[alloc_subsystem_count];     // zeroed entries use heap_allocator
+ik_alloc_stats alloc_stats[alloc_subsystem_count];
+
+void ik_set_allocator(ik_alloc_subsystem subsystem, const ik_allocator* allocator)
+{
+    allocators[subsystem] = allocator ? *allocator : ik_allocator{};
+}
+
+ik_allocator ik_get_allocator(ik_alloc_subsystem subsystem)
+{
+    return allocators[subsystem].allocate ? allocators[subsystem] : heap_allocator;
+}
+
+void* ik_alloc(ik_alloc_subsystem subsystem, u64 size)
+{
+    const ik_allocator* allocator = allocators[subsystem].allocate ? &allocators[subsystem] : &heap_allocator;
+    alloc_stats[subsystem].allocs++;
+    alloc_stats[subsystem].bytes += size;
+    return allocator->allocate(allocator->context, size);
+}
+
+void* ik_realloc(ik_alloc_subsystem subsystem, void* memory, u64 old_size, u64 size)
+{
+    if (!memory)
+    {
+        return ik_alloc(subsystem, size);
+    }
+    if (size == 0)
+    {
+        ik_free(subsystem, memory, old_size);
+        return 0;
+    }
+
+    const ik_allocator* allocator = allocators[subsystem].allocate ? &allocators[subsystem] : &heap_allocator;
+    alloc_stats[subsystem].reallocs++;
+    alloc_stats[subsystem].bytes += size;
+    return allocator->reallocate(allocator->context, memory, old_size, size);
+}
+
+void ik_free(ik_alloc_subsystem subsystem, void* memory, u64 size)
+{
+    if (!memory)
+    {
+        return;
+    }
+
+    const ik_allocator* allocator = allocators[subsystem].allocate ? &allocators[subsystem] : &heap_allocator;
+    alloc_stats[subsystem].frees++;
+    allocator->deallocate(allocator->context, memory, size);
+}
+
+ik_alloc_stats ik_get_alloc_stats(ik_alloc_subsystem subsystem)
+{
+    return alloc_stats[subsystem];
+}
+
+void ik_reset_alloc_stats()
+{
+    memset(alloc_stats, 0, sizeof(alloc_stats));
+}
+
+#pragma endregion
+
 #pragma region Math
 
 i64 ik_abs(i64 a)
@@ -25,6 +107,27 @@ void ik_remap(i64 start_min, i64 start_max, i64 res_min, i64 res_max, i64* value
     *value = res_max + (*value - start_min) * (res_max - res_min) / (start_max - start_min);
 }
 
+//the index of the lowest set bit, mask must not be 0
+u32 math_lowest_bit(u32 mask) {
+#ifdef _MSC_VER
+    unsigned long index;
+    _BitScanForward(&index, mask);
+    return index;
+#else
+    return (u32)__builtin_ctz(mask);
+#endif
+}
+
+u32 math_lowest_bit64(u64 mask) {
+#ifdef _MSC_VER
+    unsigned long index;
+    _BitScanForward64(&index, mask);
+    return index;
+#else
+    return (u32)__builtin_ctzll(mask);
+#endif
+}
+
 // Constants
 const double LN2 = 0.6931471805599453; // ln(2)
 const int NEWTON_MAX_IT = 100; // Maximum iterations for Newton's method
@@ -156,7 +259,7 @@ void ik_measure_time (char* name, void* params, measure_callback cb) {
     clock_t t;
     ik_string stripe, profiling, time = { };
     ik_string_make(&stripe, "<a>------------------------------------------------------------\n");
-    char* _p = (char*)malloc(strlen(name) + 16);
+    char* _p = (char*)ik_alloc(alloc_general, strlen(name) + 16);
     sprintf(_p, "[%s] <k>Profiling...\n", name);
 
     ik_string_make(&profiling, _p);
@@ -189,16 +292,195 @@ void ik_measure_time (char* name, void* params, measure_callback cb) {
     ik_cursor_load_pos();
     printf("\n");
 
-    free(_p);
+    ik_free(alloc_general, _p, strlen(name) + 16);
+}
+
+
+
+#pragma endregion
+
+#pragma region Arena
+
+#define ARENA_ALIGNMENT 16
+
+// every chunk starts with this, the memory handed out follows it
+typedef struct
+{
+    byte* previous;
+    u64 size;
+} arena_chunk;
+
+#define ARENA_HEADER ((sizeof(arena_chunk) + ARENA_ALIGNMENT - 1) / ARENA_ALIGNMENT * ARENA_ALIGNMENT)
+
+void ik_arena_make(ik_arena* arena, u64 chunk_size)
+{
+    memset(arena, 0, sizeof(ik_arena));
+    arena->default_chunk_size = ik_max(chunk_size, ARENA_HEADER + ARENA_ALIGNMENT);
+}
+
+//frees the current chunk and makes the one before it current
+void arena_pop_chunk(ik_arena* arena)
+{
+    arena_chunk* chunk = (arena_chunk*)arena->chunk;
+    arena->chunk = chunk->previous;
+    arena->chunk_size = arena->chunk ? ((arena_chunk*)arena->chunk)->size : 0;
+    arena->used = arena->chunk_size;
+    ik_free(alloc_arena, chunk, chunk->size);
+}
+
+bool arena_push_chunk(ik_arena* arena, u64 size)
+{
+    byte* block = (byte*)ik_alloc(alloc_arena, size);
+    if (!block)
+    {
+        return false;
+    }
+
+    arena_chunk* chunk = (arena_chunk*)block;
+    chunk->previous = arena->chunk;
+    chunk->size = size;
+    arena->chunk = block;
+    arena->chunk_size = size;
+    arena->used = ARENA_HEADER;
+    return true;
+}
+
+void ik_arena_destroy(ik_arena* arena)
+{
+    while (arena->chunk) arena_pop_chunk(arena);
+    arena->used = 0;
+}
+
+void* ik_arena_alloc(ik_arena* arena, u64 size)
+{
+    u64 offset = (arena->used + ARENA_ALIGNMENT - 1) / ARENA_ALIGNMENT * ARENA_ALIGNMENT;
+    if (!arena->chunk || offset + size > arena->chunk_size)
+    {
+        // the rest of the current chunk is left unused
+        if (!arena_push_chunk(arena, ik_max(arena->default_chunk_size, ARENA_HEADER + size)))
+        {
+            return 0;
+        }
+        offset = ARENA_HEADER;
+    }
+
+    arena->used = offset + size;
+    return arena->chunk + offset;
+}
+
+//grows the last allocation of the arena in place, false if it is not the last one or does not fit
+bool arena_extend(ik_arena* arena, void* memory, u64 size, u64 new_size)
+{
+    if (!arena->chunk || (byte*)memory + size != arena->chunk + arena->used)
+    {
+        return false;
+    }
+
+    u64 offset = (byte*)memory - arena->chunk;
+    if (offset + new_size > arena->chunk_size)
+    {
+        return false;
+    }
+    arena->used = offset + new_size;
+    return true;
+}
+
+ik_arena_mark ik_arena_get_mark(ik_arena* arena)
+{
+    return { arena->chunk, arena->used };
+}
+
+void ik_arena_reset_to(ik_arena* arena, ik_arena_mark mark)
+{
+    while (arena->chunk && arena->chunk != mark.chunk)
+    {
+        // the oldest chunk is kept for the next allocations, even for a mark from before it
+        if (!((arena_chunk*)arena->chunk)->previous && !mark.chunk)
+        {
+            arena->used = ARENA_HEADER;
+            return;
+        }
+        arena_pop_chunk(arena);
+    }
+    if (arena->chunk)
+    {
+        arena->used = mark.used;
+    }
+}
+
+void ik_arena_reset(ik_arena* arena)
+{
+    if (!arena->chunk)
+    {
+        return;
+    }
+
+    if (((arena_chunk*)arena->chunk)->previous)
+    {
+        // one chunk the size of all of them fits the same allocations again
+        u64 total = 0;
+        while (arena->chunk)
+        {
+            total += arena->chunk_size;
+            arena_pop_chunk(arena);
+        }
+        if (!arena_push_chunk(arena, total))
+        {
+            arena_push_chunk(arena, arena->default_chunk_size);
+        }
+        return;
+    }
+    arena->used = ARENA_HEADER;
+}
+
+void* arena_allocate(void* context, u64 size)
+{
+    return ik_arena_alloc((ik_arena*)context, size);
+}
+
+void* arena_reallocate(void* context, void* memory, u64 old_size, u64 size)
+{
+    ik_arena* arena = (ik_arena*)context;
+    if (arena_extend(arena, memory, old_size, size))
+    {
+        return memory;
+    }
+
+    void* moved = ik_arena_alloc(arena, size);
+    if (moved)
+    {
+        memcpy(moved, memory, ik_min(old_size, size));
+    }
+    return moved;
 }
 
+void arena_deallocate(void*, void*, u64)
+{
+    // given back with the arena
+}
 
+ik_allocator ik_arena_allocator(ik_arena* arena)
+{
+    return { arena_allocate, arena_reallocate, arena_deallocate, arena };
+}
 
 #pragma endregion
 
 #pragma region String
 
+//allocates the characters of a string from its arena or the string allocator
+char* string_alloc(ik_string* string, u64 size, ik_arena* arena)
+{
+    string->arena = arena;
+    return arena ? (char*)ik_arena_alloc(arena, size) : (char*)ik_alloc(alloc_string, size);
+}
+
 void ik_string_make(ik_string* string, const char* cstring)
+{
+    ik_string_make_arena(string, cstring, 0);
+}
+
+void ik_string_make_arena(ik_string* string, const char* cstring, ik_arena* arena)
 {
     if (0 == string || 0 == cstring)
     {
@@ -206,7 +488,7 @@ void ik_string_make(ik_string* string, const char* cstring)
     }
 
     u64 len = strlen(cstring);
-    string->cstring = (char *)malloc(len + sizeof(char));
+    string->cstring = string_alloc(string, len + sizeof(char), arena);
 
     if (!string->cstring)
     {
@@ -219,12 +501,17 @@ void ik_string_make(ik_string* string, const char* cstring)
 }
 
 void ik_string_make_empty(ik_string *string, u64 charcount)
+{
+    ik_string_make_empty_arena(string, charcount, 0);
+}
+
+void ik_string_make_empty_arena(ik_string* string, u64 charcount, ik_arena* arena)
 {
     if (0 == string)
     {
         return;
     }
-    string->cstring = (char *)malloc(charcount + sizeof(char));
+    string->cstring = string_alloc(string, charcount + sizeof(char), arena);
 
     if (!string->cstring)
     {
@@ -275,6 +562,11 @@ bool ik_string_split_at(
 }
 
 void ik_string_make_range(ik_string* string, const char* cstring, u64 start, u64 end)
+{
+    ik_string_make_range_arena(string, cstring, start, end, 0);
+}
+
+void ik_string_make_range_arena(ik_string* string, const char* cstring, u64 start, u64 end, ik_arena* arena)
 {
     if (0 == string || 0 == cstring || end < start)
     {
@@ -282,7 +574,7 @@ void ik_string_make_range(ik_string* string, const char* cstring, u64 start, u64
     }
 
     u64 len = (end - start);
-    string->cstring = (char*)malloc(len + sizeof(char));
+    string->cstring = string_alloc(string, len + sizeof(char), arena);
 
     if (!string->cstring)
     {
@@ -302,8 +594,14 @@ void ik_string_destroy(ik_string *string)
     {
         printf("");
     }*/
-    SAFEDELETE(string->cstring);
+    if (!string->arena)
+    {
+        ik_free(alloc_string, string->cstring, string->size + sizeof(char));
+    }
+    // arena strings are given back with the arena
+    string->cstring = 0;
     string->size = 0;
+    string->arena = 0;
 }
 
 void ik_string_replace(ik_string *in, char *find, char *replace)
@@ -319,7 +617,7 @@ void ik_string_replace(ik_string *in, char *find, char *replace)
 
     ik_string _new = {};
 
-    ik_string_make_empty(&_new, in->size - strlen(find) + strlen(replace));
+    ik_string_make_empty_arena(&_new, in->size - strlen(find) + strlen(replace), in->arena);
 
     bool has_replaced = false;
     for (int i = 0; i < _new.size; i++)
@@ -342,7 +640,7 @@ void ik_string_replace_index(ik_string* in, int start, int end, char* replace){
     if(start > in->size - 1 || start < 0 || end > in->size - 1 || end < 0 || start > end) return;
 
     ik_string _new = { };
-    ik_string_make_empty(&_new, in->size - (end - start) + strlen(replace) - 1);
+    ik_string_make_empty_arena(&_new, in->size - (end - start) + strlen(replace) - 1, in->arena);
     bool has_replaced = false;
     for (int i = 0; i < _new.size; i++)
     {
@@ -398,6 +696,7 @@ void ik_string_set(ik_string *in, ik_string *to)
 
     in->cstring = to->cstring;
     in->size = to->size;
+    in->arena = to->arena;
 }
 
 void ik_string_set_at(ik_string* in, int i, char to){
@@ -415,7 +714,7 @@ void ik_string_remove(ik_string *in, char *find)
 
     ik_string _new = {};
 
-    ik_string_make_empty(&_new, in->size - strlen(find));
+    ik_string_make_empty_arena(&_new, in->size - strlen(find), in->arena);
 
     bool has_replaced = false;
     int j = 0;
@@ -432,7 +731,7 @@ void ik_string_remove_range(ik_string* in, int start, int finish)
     if (start >= in->size || finish >= in->size || start > finish) return;
     ik_string _new = {};
 
-    ik_string_make_empty(&_new, in->size - (finish + 1 - start));
+    ik_string_make_empty_arena(&_new, in->size - (finish + 1 - start), in->arena);
 
     bool has_replaced = false;
     int j = 0;
@@ -445,6 +744,8 @@ void ik_string_remove_range(ik_string* in, int start, int finish)
     ik_string_set(in, &_new);
 }
 
+int screen_sgr_code(u8 c, bool background);
+
 /*HELPER FUNCTION, DO NOT USE*/
 void print(ik_string* in, reserve_space_options reserve, int spaces, align_options align) {
     if (spaces < 0) return;
@@ -487,14 +788,16 @@ void print(ik_string* in, reserve_space_options reserve, int spaces, align_optio
     }
 }
 
+// the temporaries of ik_print_string, given back when it returns
+ik_arena print_arena = { };
+
 void get_subcolors(ik_string* in, ik_array *out) {
     //formatting validating colors
     ik_string working = { };
-    ik_string_make(&working, in->cstring);
+    ik_string_make_arena(&working, in->cstring, &print_arena);
 
     ik_array found_exps = { };
-    ik_array_make(&found_exps, sizeof(size_t), 10);
-    ik_array_make(&found_exps, sizeof(size_t), 10);
+    ik_array_make_arena(&found_exps, sizeof(size_t), 10, &print_arena);
 
     ik_get_expression_indexes('<', '>', working, &found_exps);
 
@@ -513,7 +816,7 @@ void get_subcolors(ik_string* in, ik_array *out) {
             if (_old_end != -1 && begin - 1 != _old_end)
             {
                 ik_string _curr = { };
-                ik_string_make_range(&_curr, in->cstring, _old_begin, begin);
+                ik_string_make_range_arena(&_curr, in->cstring, _old_begin, begin, &print_arena);
                 ik_array_append(out, (void*)&_curr);
                 _old_begin = begin;
             }
@@ -521,21 +824,25 @@ void get_subcolors(ik_string* in, ik_array *out) {
         }
     }
     ik_string _curr = { };
-    ik_string_make_range(&_curr, in->cstring, _old_begin, in->size);
+    ik_string_make_range_arena(&_curr, in->cstring, _old_begin, in->size, &print_arena);
     ik_array_append(out, (void*)&_curr);
 }
 
 void ik_print_string(ik_string* in, reserve_space_options reserve, int spaces, align_options align)
 {
+    if (!print_arena.default_chunk_size) ik_arena_make(&print_arena, 4096);
+    ik_arena_mark mark = ik_arena_get_mark(&print_arena);
+
     //formatting validating colors
     ik_array formatted = { };
-    ik_array_make(&formatted, 2 * sizeof(u64), 10);
+    ik_array_make_arena(&formatted, sizeof(ik_string), 10, &print_arena);
 
     ik_array total_exps = { };
-    ik_array_make(&total_exps, sizeof(size_t), 10);
+    ik_array_make_arena(&total_exps, sizeof(size_t), 10, &print_arena);
     ik_get_expression_indexes('<', '>', *in, &total_exps);
 
     get_subcolors(in, &formatted);
+    size_t replacement_offset = 0;
     bool has_printed = false;
     int stringsize = 0;
     int used_spaces = 0;
@@ -545,7 +852,7 @@ void ik_print_string(ik_string* in, reserve_space_options reserve, int spaces, a
         ik_string* _curr = (ik_string*)ik_array_get(&formatted, i);
 
         ik_array found_exps = { };
-        ik_array_make(&found_exps, sizeof(size_t), 10);
+        ik_array_make_arena(&found_exps, sizeof(size_t), 10, &print_arena);
 
         ik_get_expression_indexes('<', '>', *_curr, &found_exps);
 
@@ -612,7 +919,13 @@ void ik_print_string(ik_string* in, reserve_space_options reserve, int spaces, a
             else if (option == 80) b_code = (blue | red | intensity) << 4;
             else if (option == 81) b_code = white << 4;
 
-
+// the color enum is needed again further down
+#undef black
+#undef blue
+#undef green
+#undef red
+#undef intensity
+#undef white
 
 #pragma endregion
 
@@ -623,14 +936,10 @@ void ik_print_string(ik_string* in, reserve_space_options reserve, int spaces, a
             int end = 2 + 3 * j;
 
             if (option >= 97 && option < 114) { //textcolor
-                if (option == 97) num = option - 58;
-                else if (option < 106) num = option - 68;
-                else if (option < 114) num = option - 16;
+                num = screen_sgr_code(option - 97, false);
             }
             else if (option >= 65 && option < 82) { //background
-                if (option == 65) num = option - 16;
-                else if (option < 74) num = option - 26;
-                else if (option < 82) num = option + 26;
+                num = screen_sgr_code(option - 65, true);
             }
             if (num != 0) {
                 char code[8];
@@ -768,15 +1077,16 @@ void ik_print_string(ik_string* in, reserve_space_options reserve, int spaces, a
             }
         }
 
-        SetConsoleTextAttribute(hConsole, white);
+        SetConsoleTextAttribute(hConsole, 0x0007); //white
 #endif
     }
+    ik_arena_reset_to(&print_arena, mark);
 }
 
 bool ik_read_string(ik_string *string, int max_len, type_options type, int *return_code)
 {
     char Newline[] = "\n";
-    char* buffer = (char*)malloc(max_len);
+    char* buffer = (char*)ik_alloc(alloc_string, max_len);
     fgets(buffer, max_len + 1, stdin);
 
     if (strlen(buffer) == max_len)
@@ -808,7 +1118,7 @@ bool ik_read_string(ik_string *string, int max_len, type_options type, int *retu
     // error codes
     *return_code = 3;
 
-    free(buffer);
+    ik_free(alloc_string, buffer, max_len);
     return false;
 }
 
@@ -836,7 +1146,7 @@ bool ik_get_expression_indexes(char beginning, char end, ik_string in, ik_array*
 extern void ik_string_append(ik_string* in, const char* append)
 {
 	ik_string _new = { };
-	ik_string_make_empty(&_new, in->size + strlen(append));
+	ik_string_make_empty_arena(&_new, in->size + strlen(append), in->arena);
 
 	for (int i = 0; i < in->size; i++)
 	{
@@ -853,15 +1163,26 @@ extern void ik_string_append(ik_string* in, const char* append)
 
 #pragma region Array
 
-void ik_array_make(ik_array *ik_array, u64 stride_size, u64 num_elements)
+#define ARRAY_MIN_CAPACITY 8
+#define SORT_INSERTION_MAX 16
+#define SORT_RADIX_MIN 64           // below this the comparison sorts are faster
+
+#if defined(__SSE2__) || defined(_M_X64)
+#   define ARRAY_SSE2               // the equality scans compare 16 bytes at a time
+#endif
+
+//makes an array that takes its memory from the allocator of a subsystem when it has no arena
+void array_make(ik_array* ik_array, u64 stride_size, u64 num_elements, ik_arena* arena, ik_alloc_subsystem subsystem)
 {
 	if (0 == stride_size)
 	{
         return;
 	}
 
-    ik_array->data = malloc(
-        stride_size * num_elements);
+    ik_array->arena = arena;
+    ik_array->subsystem = subsystem;
+    ik_array->data = arena ? ik_arena_alloc(arena, stride_size * num_elements) : ik_alloc(
+        subsystem, stride_size * num_elements);
 
 	if (!ik_array->data)
 	{
@@ -878,10 +1199,22 @@ void ik_array_make(ik_array *ik_array, u64 stride_size, u64 num_elements)
     ik_array->capacity = num_elements;
 }
 
+void ik_array_make(ik_array *ik_array, u64 stride_size, u64 num_elements)
+{
+    ik_array_make_arena(ik_array, stride_size, num_elements, 0);
+}
+
+void ik_array_make_arena(ik_array* ik_array, u64 stride_size, u64 num_elements, ik_arena* arena)
+{
+    array_make(ik_array, stride_size, num_elements, arena, alloc_array);
+}
+
 void ik_array_destroy(ik_array *ik_array)
 {
-    free(ik_array->data);
+    // arena memory is given back with the arena
+    if (!ik_array->arena) ik_free(ik_array->subsystem, ik_array->data, ik_array->capacity * ik_array->stride);
     ik_array->data = 0;
+    ik_array->arena = 0;
 
     ik_array->size = 0;
     ik_array->stride = 0;
@@ -892,7 +1225,9 @@ void ik_array_append(ik_array* thisptr, void* object)
 {
     if (thisptr->capacity <= thisptr->size)
     {
-        ik_array_grow(thisptr, ik_log(2 + thisptr->size));
+        // doubling keeps n appends at O(n) copying in total
+        ik_array_reserve(thisptr, ik_max(thisptr->capacity * 2, ARRAY_MIN_CAPACITY));
+        if (thisptr->capacity <= thisptr->size) return;
     }
 
     memcpy(
@@ -902,527 +1237,3871 @@ void ik_array_append(ik_array* thisptr, void* object)
     );
 }
 
-void ik_array_remove(ik_array *thisptr, u32 index)
+bool ik_array_insert(ik_array* thisptr, u64 index, void* object)
+{
+    return ik_array_insert_range(thisptr, index, object, 1);
+}
+
+bool ik_array_insert_range(ik_array* thisptr, u64 index, void* objects, u64 count)
 {
-    for (u32 i = index; i < thisptr->size - 1; i++)
+    if (index > thisptr->size)
     {
-        ik_swap(
-            ((byte *)thisptr->data) + (i * thisptr->stride),
-            ((byte *)thisptr->data) + ((i + 1) * thisptr->stride),
-            thisptr->stride);
+        return false;
     }
-    thisptr->size--;
+    if (thisptr->capacity < thisptr->size + count &&
+        !ik_array_reserve(thisptr, ik_max(ik_max(thisptr->capacity * 2, thisptr->size + count), ARRAY_MIN_CAPACITY)))
+    {
+        return false;
+    }
+
+    // one move opens the gap for all of them
+    byte* at = (byte*)thisptr->data + index * thisptr->stride;
+    memmove(at + count * thisptr->stride, at, (thisptr->size - index) * thisptr->stride);
+    memcpy(at, objects, count * thisptr->stride);
+    thisptr->size += count;
+    return true;
 }
 
-void ik_array_remove_fast(ik_array *thisptr, u32 index)
+void ik_array_remove(ik_array *thisptr, u32 index)
 {
-    ik_swap(
-        ((byte *)thisptr->data) + (index * thisptr->stride),
-        ((byte *)thisptr->data) + ((thisptr->size - 1) * thisptr->stride),
-        thisptr->stride);
+    ik_array_remove_range(thisptr, index, 1);
 }
 
-void ik_array_sort(ik_array *thisptr, compare_callback comparator, ik_array_sort_mode mode)
+void ik_array_remove_range(ik_array* thisptr, u64 index, u64 count)
 {
-	if (!comparator || !thisptr->size)
-		return;
-
-    bool is_sorted = false;
-    while (!is_sorted)
+    if (index >= thisptr->size)
     {
-        is_sorted = true;
-        for (u32 i = 0; i < thisptr->size - 1; i++)
-        {
-            void *first_element = ik_array_get(thisptr, i);
-            void *second_element = ik_array_get(thisptr, i + 1);
-
-            bool comp = comparator(
-                first_element,
-                second_element);
-
-            if (mode == ik_array_sort_mode::asc ? comp : !comp)
-            {
-                is_sorted = false;
-                ik_swap(
-                    first_element,
-                    second_element,
-                    thisptr->stride);
-            }
-        }
+        return;
     }
+    count = ik_min(count, thisptr->size - index);
+
+    byte* at = (byte*)thisptr->data + index * thisptr->stride;
+    memmove(at, at + count * thisptr->stride, (thisptr->size - index - count) * thisptr->stride);
+    thisptr->size -= count;
 }
 
-void ik_array_grow(ik_array *thisptr, u64 size)
+void ik_array_remove_fast(ik_array *thisptr, u32 index)
 {
-    void *temp = thisptr->data;
-
-    u32 new_capacity = (thisptr->capacity + size);
-    void* new_data = malloc(new_capacity * thisptr->stride);
-    if (!new_data)
+    if (index >= thisptr->size)
     {
-	    return;
+        return;
     }
 
-	thisptr->data = new_data;
-    memset(
-        (byte*)new_data + (thisptr->size * thisptr->stride),
-        0,
-        (new_capacity - thisptr->size) * thisptr->stride
-    );
-
-    memcpy(
-        thisptr->data,
-        temp,
-        thisptr->size * thisptr->stride
-    );
-
-    thisptr->capacity = new_capacity;
-
-    SAFEDELETE(temp);
+    // the last element takes its place, nothing has to be kept of the removed one
+    thisptr->size--;
+    if (index != thisptr->size)
+    {
+        memcpy(
+            ((byte *)thisptr->data) + (index * thisptr->stride),
+            ((byte *)thisptr->data) + (thisptr->size * thisptr->stride),
+            thisptr->stride);
+    }
 }
 
-void* ik_array_get(ik_array *thisptr, u32 i)
+u64 ik_array_erase_if(ik_array* thisptr, predicate_callback predicate, void* user_data)
 {
-	if (i >= thisptr->size)
-	{
-		return ((byte*)thisptr->data) + (thisptr->size - 1) * thisptr->stride;
-	}
+    // the elements that stay are moved down a run at a time
+    byte* data = (byte*)thisptr->data;
+    u64 stride = thisptr->stride;
+    u64 kept = 0;
+    u64 i = 0;
+    while (i < thisptr->size)
+    {
+        if (predicate(data + i * stride, user_data))
+        {
+            i++;
+            continue;
+        }
 
-    return ((byte *)thisptr->data) + i * thisptr->stride;
+        u64 run = i + 1;
+        while (run < thisptr->size && !predicate(data + run * stride, user_data)) run++;
+        if (kept != i)
+        {
+            memmove(data + kept * stride, data + i * stride, (run - i) * stride);
+        }
+        kept += run - i;
+        // the element that ended the run was already tested and is removed
+        i = run + 1;
+    }
+
+    u64 removed = thisptr->size - kept;
+    thisptr->size = kept;
+    return removed;
 }
 
-void ik_swap(void *src, void *dst, u64 size)
+// sorting works on the raw bytes, before() turns the greater-than comparators into the order of the mode
+typedef struct
 {
-    void *temp = malloc(size);
+    compare_callback comparator;
+    bool descending;
+    u64 stride;
+    byte* tmp;          // room for one element
+} sort_context;
 
-	if (!temp)
-	{
-		return;
-	}
-
-    memcpy(temp, src, size);
-    memcpy(src, dst, size);
-    memcpy(dst, temp, size);
+ik_array sort_scratch = {};     // the mergesort buffer, kept for the next sort
 
-    SAFEDELETE(temp);
-}
-
-bool ik_array_contains(ik_array* thisptr, void* object, compare_callback comparator)
+bool sort_before(sort_context* c, byte* a, byte* b)
 {
-	for (u32 i = 0; i < thisptr->size; i++)
-	{
-		if (comparator && comparator(object, ik_array_get(thisptr, i)))
-		{
-			return true;
-		}
-		if (!comparator && memcmp(object, ik_array_get(thisptr, i), thisptr->stride) == 0)
-		{
-			return true;
-		}
-	}
-	return false;
+    return c->descending ? c->comparator(a, b) : c->comparator(b, a);
 }
 
-#pragma endregion
-
-#pragma region Parsers
-
-i32 ik_parser_comma_index(char *text)
+//stable, used for short ranges by both sorts
+void sort_insertion(sort_context* c, byte* first, u64 n)
 {
-    for (i32 i = 0; i < strlen(text); i++)
+    u64 stride = c->stride;
+    for (u64 i = 1; i < n; i++)
     {
-        if (text[i] == ',')
+        byte* element = first + i * stride;
+        if (!sort_before(c, element, element - stride))
         {
-            return i;
+            continue;
+        }
+
+        memcpy(c->tmp, element, stride);
+        u64 j = i - 1;
+        while (j > 0 && sort_before(c, c->tmp, first + (j - 1) * stride))
+        {
+            j--;
         }
+        memmove(first + (j + 1) * stride, first + j * stride, (i - j) * stride);
+        memcpy(first + j * stride, c->tmp, stride);
     }
-    return -1;
 }
 
-u64 ik_parser_decimal_count(char *text, i32 comma_index)
+void sort_sift_down(sort_context* c, byte* first, u64 root, u64 n)
 {
-    return strlen(text) - 1 - comma_index;
+    u64 stride = c->stride;
+    for (u64 child = 2 * root + 1; child < n; child = 2 * root + 1)
+    {
+        if (child + 1 < n && sort_before(c, first + child * stride, first + (child + 1) * stride))
+        {
+            child++;
+        }
+        if (!sort_before(c, first + root * stride, first + child * stride))
+        {
+            return;
+        }
+        ik_swap(first + root * stride, first + child * stride, stride);
+        root = child;
+    }
 }
 
-bool ik_parser_parse_as_int(ik_string *text, int *out_number)
+//the fallback when quicksort keeps picking bad pivots, O(n log n) on any input
+void sort_heap(sort_context* c, byte* first, u64 n)
 {
-    *out_number = 0;
+    for (u64 i = n / 2; i-- > 0;)
+    {
+        sort_sift_down(c, first, i, n);
+    }
+    for (u64 end = n - 1; end > 0; end--)
+    {
+        ik_swap(first, first + end * c->stride, c->stride);
+        sort_sift_down(c, first, 0, end);
+    }
+}
 
-    // check if text is null
-    if (text == 0)
+void sort_intro(sort_context* c, byte* first, u64 n, u32 depth)
+{
+    u64 stride = c->stride;
+    while (n > SORT_INSERTION_MAX)
     {
-        return 0;
+        if (depth-- == 0)
+        {
+            sort_heap(c, first, n);
+            return;
+        }
+
+        // the median of first, middle and last becomes the pivot at the front, last is then no smaller than it
+        byte* mid = first + (n / 2) * stride;
+        byte* last = first + (n - 1) * stride;
+        if (sort_before(c, mid, first)) ik_swap(mid, first, stride);
+        if (sort_before(c, last, mid))
+        {
+            ik_swap(last, mid, stride);
+            if (sort_before(c, mid, first)) ik_swap(mid, first, stride);
+        }
+        ik_swap(first, mid, stride);
+
+        // both scans stop at elements equal to the pivot, so runs of equal elements split evenly
+        u64 i = 1, j = n - 1;
+        for (;;)
+        {
+            while (i <= j && sort_before(c, first + i * stride, first)) i++;
+            while (j >= i && sort_before(c, first, first + j * stride)) j--;
+            if (i >= j) break;
+            ik_swap(first + i * stride, first + j * stride, stride);
+            i++;
+            j--;
+        }
+        ik_swap(first, first + j * stride, stride);
+
+        // recursing into the smaller side bounds the stack at log n
+        u64 left = j, right = n - j - 1;
+        if (left < right)
+        {
+            sort_intro(c, first, left, depth);
+            first += (j + 1) * stride;
+            n = right;
+        }
+        else
+        {
+            sort_intro(c, first + (j + 1) * stride, right, depth);
+            n = left;
+        }
     }
+    sort_insertion(c, first, n);
+}
 
-    ik_string fixed_comma = {};
-    ik_string_make(&fixed_comma, text->cstring);
-    ik_string comma = { };
-    ik_string_make(&comma, ",");
-    ik_string dot = { };
-    ik_string_make(&dot, ".");
-    ik_string_replace(&fixed_comma, (&comma)->cstring, (&dot)->cstring);
+void sort_merge(sort_context* c, byte* first, u64 n)
+{
+    if (n <= SORT_INSERTION_MAX)
+    {
+        sort_insertion(c, first, n);
+        return;
+    }
 
-    if (ik_is_numeric(text->cstring))
-        ik_round_to_int(atof(fixed_comma.cstring), out_number);
+    u64 stride = c->stride;
+    u64 half = n / 2;
+    byte* mid = first + half * stride;
+    sort_merge(c, first, half);
+    sort_merge(c, mid, n - half);
+    if (!sort_before(c, mid, mid - stride))
+    {
+        return;
+    }
+
+    // the left half waits in the scratch buffer, ties take the left element to stay stable
+    byte* left = (byte*)sort_scratch.data;
+    byte* left_end = left + half * stride;
+    byte* right = mid;
+    byte* right_end = first + n * stride;
+    byte* out = first;
+    memcpy(left, first, half * stride);
+    while (left < left_end && right < right_end)
+    {
+        byte** from = sort_before(c, right, left) ? &right : &left;
+        memcpy(out, *from, stride);
+        *from += stride;
+        out += stride;
+    }
+    // what is left of the right half is in place already
+    memcpy(out, left, left_end - left);
+}
+
+// the built-in comparators tell the key type, those arrays are radix sorted on keys that compare
+// as unsigned integers. Signed keys get their sign bit flipped, floats all bits if negative and
+// the sign bit if not, a descending sort inverts the key.
+typedef enum
+{
+    radix_unsigned,
+    radix_signed,
+    radix_float
+} radix_kind;
+
+u64 radix_encode(u64 bits, u64 sign, u64 mask, radix_kind kind, bool descending)
+{
+    if (kind == radix_signed) bits ^= sign;
+    else if (kind == radix_float) bits = (bits & sign) ? ~bits & mask : bits | sign;
+    return descending ? ~bits & mask : bits;
+}
+
+u64 radix_decode(u64 bits, u64 sign, u64 mask, radix_kind kind, bool descending)
+{
+    if (descending) bits = ~bits & mask;
+    if (kind == radix_signed) bits ^= sign;
+    else if (kind == radix_float) bits = (bits & sign) ? bits ^ sign : ~bits & mask;
+    return bits;
+}
+
+//LSD radix sort of n elements of size bytes, encodes the keys in the counting pass and decodes them after the last one
+void sort_radix_keys(byte* data, byte* scratch, u64 n, u32 size, radix_kind kind, bool descending)
+{
+    u64 sign = 1ull << (size * 8 - 1);
+    u64 mask = size == 8 ? ~0ull : (1ull << (size * 8)) - 1;
+
+    // one pass over the data counts every digit, a digit that is the same everywhere skips its pass
+    u64 counts[8][256] = {};
+    if (size == 4)
+    {
+        u32* keys = (u32*)data;
+        for (u64 i = 0; i < n; i++)
+        {
+            u32 key = (u32)radix_encode(keys[i], sign, mask, kind, descending);
+            keys[i] = key;
+            counts[0][key & 0xFF]++;
+            counts[1][(key >> 8) & 0xFF]++;
+            counts[2][(key >> 16) & 0xFF]++;
+            counts[3][key >> 24]++;
+        }
+    }
+    else if (size == 8)
+    {
+        u64* keys = (u64*)data;
+        for (u64 i = 0; i < n; i++)
+        {
+            u64 key = radix_encode(keys[i], sign, mask, kind, descending);
+            keys[i] = key;
+            for (u32 d = 0; d < 8; d++)
+            {
+                counts[d][(key >> (d * 8)) & 0xFF]++;
+            }
+        }
+    }
+    else
+    {
+        for (u64 i = 0; i < n; i++)
+        {
+            data[i] = (byte)radix_encode(data[i], sign, mask, kind, descending);
+            counts[0][data[i]]++;
+        }
+    }
+
+    byte* from = data;
+    byte* to = scratch;
+    for (u32 d = 0; d < size; d++)
+    {
+        u64 first = 0;
+        memcpy(&first, from, size);
+        if (counts[d][(first >> (d * 8)) & 0xFF] == n)
+        {
+            continue;
+        }
+
+        u64 offsets[256];
+        u64 sum = 0;
+        for (u32 b = 0; b < 256; b++)
+        {
+            offsets[b] = sum;
+            sum += counts[d][b];
+        }
+        if (size == 4)
+        {
+            for (u64 i = 0; i < n; i++)
+            {
+                u32 key = ((u32*)from)[i];
+                ((u32*)to)[offsets[(key >> (d * 8)) & 0xFF]++] = key;
+            }
+        }
+        else if (size == 8)
+        {
+            for (u64 i = 0; i < n; i++)
+            {
+                u64 key = ((u64*)from)[i];
+                ((u64*)to)[offsets[(key >> (d * 8)) & 0xFF]++] = key;
+            }
+        }
+        else
+        {
+            for (u64 i = 0; i < n; i++)
+            {
+                to[offsets[from[i]]++] = from[i];
+            }
+        }
+        byte* swap = from;
+        from = to;
+        to = swap;
+    }
+
+    if (size == 4)
+    {
+        for (u64 i = 0; i < n; i++)
+        {
+            ((u32*)data)[i] = (u32)radix_decode(((u32*)from)[i], sign, mask, kind, descending);
+        }
+    }
+    else if (size == 8)
+    {
+        for (u64 i = 0; i < n; i++)
+        {
+            ((u64*)data)[i] = radix_decode(((u64*)from)[i], sign, mask, kind, descending);
+        }
+    }
     else
+    {
+        for (u64 i = 0; i < n; i++)
+        {
+            data[i] = (byte)radix_decode(from[i], sign, mask, kind, descending);
+        }
+    }
+}
+
+//sorts arrays of the built-in numeric types without calling the comparator, false if the array is none
+bool sort_radix(ik_array* thisptr, compare_callback comparator, ik_array_sort_mode mode)
+{
+    static const struct { compare_callback comparator; u32 size; radix_kind kind; } types[] = {
+        { ik_compare_byte, 1, radix_unsigned },
+        { ik_compare_u32, 4, radix_unsigned }, { ik_compare_i32, 4, radix_signed }, { ik_compare_f32, 4, radix_float },
+        { ik_compare_u64, 8, radix_unsigned }, { ik_compare_i64, 8, radix_signed }, { ik_compare_f64, 8, radix_float },
+    };
+    if (thisptr->size < SORT_RADIX_MIN)
+    {
         return false;
-    return true;
+    }
+
+    for (u32 t = 0; t < sizeof(types) / sizeof(types[0]); t++)
+    {
+        if (types[t].comparator != comparator || types[t].size != thisptr->stride) continue;
+
+        if (!sort_scratch.stride)
+        {
+            ik_array_make(&sort_scratch, sizeof(byte), 0);
+        }
+        if (!ik_array_reserve(&sort_scratch, thisptr->size * types[t].size))
+        {
+            return false;
+        }
+        sort_radix_keys((byte*)thisptr->data, (byte*)sort_scratch.data, thisptr->size, types[t].size,
+            types[t].kind, mode == ik_array_sort_mode::desc);
+        return true;
+    }
+    return false;
 }
 
-bool ik_parser_parse_as_float(ik_string *text, float *out_number)
+//sets up the context, returns false if there is nothing to sort
+bool sort_begin(sort_context* c, ik_array* thisptr, compare_callback comparator, ik_array_sort_mode mode, byte* stack, u64 stack_size)
 {
-    *out_number = 0;
+    if (!comparator || thisptr->size < 2 || thisptr->stride == 0)
+    {
+        return false;
+    }
+    c->comparator = comparator;
+    c->descending = mode == ik_array_sort_mode::desc;
+    c->stride = thisptr->stride;
+    c->tmp = thisptr->stride <= stack_size ? stack : (byte*)ik_alloc(alloc_array, thisptr->stride);
+    return c->tmp != 0;
+}
 
-    // check if text is null
-    if (text == 0)
+void sort_end(sort_context* c, byte* stack)
+{
+    if (c->tmp != stack)
     {
-        return 0;
+        ik_free(alloc_array, c->tmp, c->stride);
     }
+}
 
-    ik_string fixed_comma = {};
-    ik_string_make(&fixed_comma, text->cstring);
+void ik_array_sort(ik_array *thisptr, compare_callback comparator, ik_array_sort_mode mode)
+{
+    if (sort_radix(thisptr, comparator, mode))
+    {
+        return;
+    }
 
-    ik_string comma = { };
-    ik_string_make(&comma, ",");
-    ik_string dot = { };
-    ik_string_make(&dot, ".");
-    ik_string_replace(&fixed_comma, (&comma)->cstring, (&dot)->cstring);
+    sort_context c;
+    byte stack[256];
+    if (!sort_begin(&c, thisptr, comparator, mode, stack, sizeof(stack)))
+    {
+        return;
+    }
 
+    u32 depth = 0;
+    for (u64 n = thisptr->size; n > 1; n >>= 1)
+    {
+        depth += 2;
+    }
+    sort_intro(&c, (byte*)thisptr->data, thisptr->size, depth);
+    sort_end(&c, stack);
+}
 
-    if (!ik_is_numeric(text->cstring))
+void ik_array_sort_stable(ik_array* thisptr, compare_callback comparator, ik_array_sort_mode mode)
+{
+    if (sort_radix(thisptr, comparator, mode))
+    {
+        return;
+    }
+
+    sort_context c;
+    byte stack[256];
+    if (!sort_begin(&c, thisptr, comparator, mode, stack, sizeof(stack)))
+    {
+        return;
+    }
+
+    if (!sort_scratch.stride)
+    {
+        ik_array_make(&sort_scratch, sizeof(byte), 0);
+    }
+    if (ik_array_reserve(&sort_scratch, (thisptr->size / 2) * thisptr->stride))
+    {
+        sort_merge(&c, (byte*)thisptr->data, thisptr->size);
+    }
+    sort_end(&c, stack);
+}
+
+//reallocates the array to exactly capacity elements, the slots past the size are zeroed
+bool array_set_capacity(ik_array* thisptr, u64 capacity)
+{
+    if (capacity == thisptr->capacity)
+    {
+        return true;
+    }
+    if (capacity == 0)
+    {
+        if (!thisptr->arena) ik_free(thisptr->subsystem, thisptr->data, thisptr->capacity * thisptr->stride);
+        thisptr->data = 0;
+        thisptr->capacity = 0;
+        return true;
+    }
+
+    void* new_data = thisptr->data;
+    if (thisptr->arena)
+    {
+        // arena blocks are not freed, shrinking keeps the block and growing takes a new one unless
+        // the array is the last allocation and the chunk has room
+        if (capacity > thisptr->capacity && !(thisptr->data &&
+            arena_extend(thisptr->arena, thisptr->data, thisptr->capacity * thisptr->stride, capacity * thisptr->stride)))
+        {
+            new_data = ik_arena_alloc(thisptr->arena, capacity * thisptr->stride);
+            if (!new_data)
+            {
+                return false;
+            }
+            if (thisptr->data) memcpy(new_data, thisptr->data, thisptr->capacity * thisptr->stride);
+        }
+    }
+    else
+    {
+        new_data = ik_realloc(thisptr->subsystem, thisptr->data, thisptr->capacity * thisptr->stride, capacity * thisptr->stride);
+    }
+    if (!new_data)
+    {
         return false;
-    float out = (float)atof(fixed_comma.cstring);
-    *out_number = out;
+    }
+
+    thisptr->data = new_data;
+    if (capacity > thisptr->capacity)
+    {
+        memset(
+            (byte*)new_data + (thisptr->capacity * thisptr->stride),
+            0,
+            (capacity - thisptr->capacity) * thisptr->stride
+        );
+    }
+    thisptr->capacity = capacity;
     return true;
 }
 
-#pragma endregion
+void ik_array_grow(ik_array *thisptr, u64 size)
+{
+    array_set_capacity(thisptr, thisptr->capacity + size);
+}
 
-#pragma region Random
+bool ik_array_reserve(ik_array* thisptr, u64 capacity)
+{
+    if (thisptr->stride == 0)
+    {
+        return false;
+    }
+    return capacity <= thisptr->capacity || array_set_capacity(thisptr, capacity);
+}
 
-void ik_random_init(ik_random* state, u32 seed) 
+void ik_array_shrink_to_fit(ik_array* thisptr)
 {
-    u32* state_array = &(state->state_array[0]);
-    
-    state_array[0] = seed; // suggested initial seed = 19650218UL
-    
-    for (int i=1; i<624; i++)
+    if (thisptr->stride == 0)
     {
-        seed = 1812433253UL * (seed ^ (seed >> (32-2))) + i; 
-        state_array[i] = seed; 
+        return;
     }
-    
-    state->state_index = 0;
+    array_set_capacity(thisptr, thisptr->size);
 }
 
+bool ik_array_resize(ik_array* thisptr, u64 size)
+{
+    if (!ik_array_reserve(thisptr, size))
+    {
+        return false;
+    }
+
+    // elements dropped by an earlier resize may still hold data
+    if (size > thisptr->size)
+    {
+        memset(
+            (byte*)thisptr->data + thisptr->size * thisptr->stride,
+            0,
+            (size - thisptr->size) * thisptr->stride
+        );
+    }
+    thisptr->size = size;
+    return true;
+}
 
-void ik_random_next(ik_random* state, i32* out)
+void* ik_array_get(ik_array *thisptr, u32 i)
 {
-    u32* state_array = &(state->state_array[0]);
-    
-    int k = state->state_index;      
-    int j = k - (624-1);               
-    if (j < 0) j += 624;               
+	if (i >= thisptr->size)
+	{
+		return ((byte*)thisptr->data) + (thisptr->size - 1) * thisptr->stride;
+	}
 
-    u32 x = (state_array[k] & (0xffffffffUL << 31)) | (state_array[j] & (0xffffffffUL >> (32-31)));
-    
-    u32 xA = x >> 1;
-    if (x & 0x00000001UL) xA ^= 0x9908b0dfUL;
-    
-    j = k - (624-397);
-    if (j < 0) j += 624;
-    
-    x = state_array[j] ^ xA;
-    state_array[k++] = x;
-    
-    if (k >= 624) k = 0;
-    state->state_index = k;
-    
-    u32 y = x ^ (x >> 11);
-            y = y ^ ((y << 7) & 0x9d2c5680UL);
-            y = y ^ ((y << 15) & 0xefc60000UL);
-    u32 z = y ^ (y >> 18);
-    
-    *out = z; 
+    return ((byte *)thisptr->data) + i * thisptr->stride;
+}
+
+void ik_swap(void *src, void *dst, u64 size)
+{
+    // the common sizes go through a register, larger ones through a stack chunk at a time
+    if (size == sizeof(u32))
+    {
+        u32 temp;
+        memcpy(&temp, src, sizeof(temp));
+        memcpy(src, dst, sizeof(temp));
+        memcpy(dst, &temp, sizeof(temp));
+        return;
+    }
+    if (size == sizeof(u64))
+    {
+        u64 temp;
+        memcpy(&temp, src, sizeof(temp));
+        memcpy(src, dst, sizeof(temp));
+        memcpy(dst, &temp, sizeof(temp));
+        return;
+    }
+
+    byte chunk[64];
+    byte* a = (byte*)src;
+    byte* b = (byte*)dst;
+    while (size > 0)
+    {
+        u64 n = ik_min(size, sizeof(chunk));
+        memcpy(chunk, a, n);
+        memcpy(a, b, n);
+        memcpy(b, chunk, n);
+        a += n;
+        b += n;
+        size -= n;
+    }
+}
+
+#ifdef ARRAY_SSE2
+u32 array_bit_count(u32 mask) {
+    mask = mask - ((mask >> 1) & 0x55555555);
+    mask = (mask & 0x33333333) + ((mask >> 2) & 0x33333333);
+    return (((mask + (mask >> 4)) & 0x0F0F0F0F) * 0x01010101) >> 24;
+}
+
+//compares the 16 bytes of a block with the value, every matching element sets stride bits of the mask
+inline u32 array_match_mask(__m128i block, __m128i value, u64 stride)
+{
+    switch (stride)
+    {
+    case 1: return (u32)_mm_movemask_epi8(_mm_cmpeq_epi8(block, value));
+    case 2: return (u32)_mm_movemask_epi8(_mm_cmpeq_epi16(block, value));
+    case 4: return (u32)_mm_movemask_epi8(_mm_cmpeq_epi32(block, value));
+    case 8:
+    {
+        // there is no 64-bit compare in SSE2, both halves have to match
+        __m128i halves = _mm_cmpeq_epi32(block, value);
+        return (u32)_mm_movemask_epi8(_mm_and_si128(halves, _mm_shuffle_epi32(halves, _MM_SHUFFLE(2, 3, 0, 1))));
+    }
+    default: return _mm_movemask_epi8(_mm_cmpeq_epi8(block, value)) == 0xFFFF ? 0xFFFF : 0;
+    }
+}
+
+//scans 16 bytes at a time, returns the first match or counts all of them if count is given
+inline i64 array_scan_stride(ik_array* thisptr, void* object, u64 stride, u64* count)
+{
+    // the object repeated over a whole block
+    byte pattern[16];
+    for (u64 i = 0; i < 16; i += stride)
+    {
+        memcpy(pattern + i, object, stride);
+    }
+    __m128i value = _mm_loadu_si128((__m128i*)pattern);
+
+    byte* data = (byte*)thisptr->data;
+    u64 bytes = thisptr->size * stride;
+    u64 offset = 0;
+    for (; offset + 16 <= bytes; offset += 16)
+    {
+        u32 mask = array_match_mask(_mm_loadu_si128((__m128i*)(data + offset)), value, stride);
+        if (!mask) continue;
+
+        if (!count) return (i64)((offset + math_lowest_bit(mask)) / stride);
+        *count += array_bit_count(mask) / stride;
+    }
+    for (; offset < bytes; offset += stride)
+    {
+        if (memcmp(data + offset, object, stride) != 0) continue;
+
+        if (!count) return (i64)(offset / stride);
+        (*count)++;
+    }
+    return -1;
+}
+#endif
+
+//the first element that matches, or the number of matches if count is given
+i64 array_scan(ik_array* thisptr, void* object, compare_callback comparator, u64* count)
+{
+    if (!comparator)
+    {
+#ifdef ARRAY_SSE2
+        // a constant stride for every kernel, so the compiler can fold the switch in the mask
+        switch (thisptr->stride)
+        {
+        case 1: return array_scan_stride(thisptr, object, 1, count);
+        case 2: return array_scan_stride(thisptr, object, 2, count);
+        case 4: return array_scan_stride(thisptr, object, 4, count);
+        case 8: return array_scan_stride(thisptr, object, 8, count);
+        case 16: return array_scan_stride(thisptr, object, 16, count);
+        }
+#endif
+    }
+
+    byte* data = (byte*)thisptr->data;
+    for (u64 i = 0; i < thisptr->size; i++)
+    {
+        byte* element = data + i * thisptr->stride;
+        if (comparator ? !comparator(object, element) : memcmp(object, element, thisptr->stride) != 0) continue;
+
+        if (!count) return (i64)i;
+        (*count)++;
+    }
+    return -1;
+}
+
+bool ik_array_contains(ik_array* thisptr, void* object, compare_callback comparator)
+{
+    return array_scan(thisptr, object, comparator, 0) >= 0;
+}
+
+i64 ik_array_find_index(ik_array* thisptr, void* object, compare_callback comparator)
+{
+    return array_scan(thisptr, object, comparator, 0);
+}
+
+u64 ik_array_count(ik_array* thisptr, void* object, compare_callback comparator)
+{
+    u64 count = 0;
+    array_scan(thisptr, object, comparator, &count);
+    return count;
+}
+
+// the sorted array operations order elements like the sorts do, with sort_before()
+u64 ik_array_lower_bound(ik_array* thisptr, void* object, compare_callback comparator, ik_array_sort_mode mode)
+{
+    sort_context c = { comparator, mode == ik_array_sort_mode::desc, thisptr->stride, 0 };
+    u64 first = 0;
+    u64 count = thisptr->size;
+    while (count > 0)
+    {
+        u64 half = count / 2;
+        if (sort_before(&c, (byte*)thisptr->data + (first + half) * c.stride, (byte*)object))
+        {
+            first += half + 1;
+            count -= half + 1;
+        }
+        else
+        {
+            count = half;
+        }
+    }
+    return first;
+}
+
+u64 ik_array_upper_bound(ik_array* thisptr, void* object, compare_callback comparator, ik_array_sort_mode mode)
+{
+    sort_context c = { comparator, mode == ik_array_sort_mode::desc, thisptr->stride, 0 };
+    u64 first = 0;
+    u64 count = thisptr->size;
+    while (count > 0)
+    {
+        u64 half = count / 2;
+        if (!sort_before(&c, (byte*)object, (byte*)thisptr->data + (first + half) * c.stride))
+        {
+            first += half + 1;
+            count -= half + 1;
+        }
+        else
+        {
+            count = half;
+        }
+    }
+    return first;
+}
+
+i64 ik_array_binary_search(ik_array* thisptr, void* object, compare_callback comparator, ik_array_sort_mode mode)
+{
+    sort_context c = { comparator, mode == ik_array_sort_mode::desc, thisptr->stride, 0 };
+    u64 index = ik_array_lower_bound(thisptr, object, comparator, mode);
+    if (index < thisptr->size && !sort_before(&c, (byte*)object, (byte*)thisptr->data + index * c.stride))
+    {
+        return (i64)index;
+    }
+    return -1;
+}
+
+bool ik_array_insert_sorted(ik_array* thisptr, void* object, compare_callback comparator, ik_array_sort_mode mode)
+{
+    // after the equal ones, so elements inserted one by one keep their order
+    return ik_array_insert(thisptr, ik_array_upper_bound(thisptr, object, comparator, mode), object);
+}
+
+bool ik_array_merge(ik_array* out, ik_array* a, ik_array* b, compare_callback comparator, ik_array_sort_mode mode)
+{
+    if (out->stride != a->stride || out->stride != b->stride || out == a || out == b)
+    {
+        return false;
+    }
+    if (!ik_array_reserve(out, out->size + a->size + b->size))
+    {
+        return false;
+    }
+
+    sort_context c = { comparator, mode == ik_array_sort_mode::desc, out->stride, 0 };
+    byte* dst = (byte*)out->data + out->size * c.stride;
+    byte* left = (byte*)a->data;
+    byte* left_end = left + a->size * c.stride;
+    byte* right = (byte*)b->data;
+    byte* right_end = right + b->size * c.stride;
+    while (left < left_end && right < right_end)
+    {
+        // equal elements are taken from a first
+        if (sort_before(&c, right, left))
+        {
+            memcpy(dst, right, c.stride);
+            right += c.stride;
+        }
+        else
+        {
+            memcpy(dst, left, c.stride);
+            left += c.stride;
+        }
+        dst += c.stride;
+    }
+    memcpy(dst, left, left_end - left);
+    dst += left_end - left;
+    memcpy(dst, right, right_end - right);
+
+    out->size += a->size + b->size;
+    return true;
+}
+
+#pragma endregion
+
+#pragma region Hash Map
+
+#define HASHMAP_GROUP 16            // control bytes compared at once
+#define HASHMAP_EMPTY ((byte)0x80)
+#define HASHMAP_DELETED ((byte)0xFE)  // full slots keep 7 bits of the hash, so only free ones have the high bit set
+
+u64 hash_rotate(u64 value, u32 bits)
+{
+    return (value << bits) | (value >> (64 - bits));
+}
+
+u64 ik_hash_bytes(const void* data, u64 size)
+{
+    // murmur3 style mixing of whole words, then a final avalanche
+    const byte* bytes = (const byte*)data;
+    u64 hash = 0x9E3779B97F4A7C15ull ^ (size * 0xC2B2AE3D27D4EB4Full);
+    while (size >= 8)
+    {
+        u64 word;
+        memcpy(&word, bytes, 8);
+        word = hash_rotate(word * 0x87C37B91114253D5ull, 31) * 0x4CF5AD432745937Full;
+        hash = hash_rotate(hash ^ word, 27) * 5 + 0x52DCE729;
+        bytes += 8;
+        size -= 8;
+    }
+    if (size > 0)
+    {
+        u64 word = 0;
+        memcpy(&word, bytes, size);
+        word = hash_rotate(word * 0x87C37B91114253D5ull, 31) * 0x4CF5AD432745937Full;
+        hash ^= word;
+    }
+    hash ^= hash >> 33;
+    hash *= 0xFF51AFD7ED558CCDull;
+    hash ^= hash >> 33;
+    hash *= 0xC4CEB9FE1A85EC53ull;
+    return hash ^ (hash >> 33);
+}
+
+u64 ik_hash_string(void* key)
+{
+    return ik_hash_bytes(((ik_string*)key)->cstring, ((ik_string*)key)->size);
+}
+
+bool ik_equals_string(void* a, void* b)
+{
+    ik_string* _a = (ik_string*)a;
+    ik_string* _b = (ik_string*)b;
+    return _a->size == _b->size && memcmp(_a->cstring, _b->cstring, _a->size) == 0;
+}
+
+//a bit for every slot of the group whose control byte is the given one
+u32 hashmap_match(byte* group, byte control)
+{
+#ifdef ARRAY_SSE2
+    __m128i bytes = _mm_loadu_si128((__m128i*)group);
+    return (u32)_mm_movemask_epi8(_mm_cmpeq_epi8(bytes, _mm_set1_epi8((char)control)));
+#else
+    u32 mask = 0;
+    for (u32 i = 0; i < HASHMAP_GROUP; i++)
+    {
+        mask |= (u32)(group[i] == control) << i;
+    }
+    return mask;
+#endif
+}
+
+//a bit for every empty or deleted slot of the group
+u32 hashmap_match_free(byte* group)
+{
+#ifdef ARRAY_SSE2
+    return (u32)_mm_movemask_epi8(_mm_loadu_si128((__m128i*)group));
+#else
+    u32 mask = 0;
+    for (u32 i = 0; i < HASHMAP_GROUP; i++)
+    {
+        mask |= (u32)(group[i] >> 7) << i;
+    }
+    return mask;
+#endif
+}
+
+u64 hashmap_hash(ik_hashmap* map, void* key)
+{
+    return map->hash ? map->hash(key) : ik_hash_bytes(key, map->key_stride);
+}
+
+bool hashmap_equals(ik_hashmap* map, void* a, void* b)
+{
+    if (map->equals)
+    {
+        return map->equals(a, b);
+    }
+
+    // ids and coordinates are compared as one word
+    if (map->key_stride == sizeof(u64))
+    {
+        u64 _a, _b;
+        memcpy(&_a, a, sizeof(u64));
+        memcpy(&_b, b, sizeof(u64));
+        return _a == _b;
+    }
+    if (map->key_stride == sizeof(u32))
+    {
+        u32 _a, _b;
+        memcpy(&_a, a, sizeof(u32));
+        memcpy(&_b, b, sizeof(u32));
+        return _a == _b;
+    }
+    return memcmp(a, b, map->key_stride) == 0;
+}
+
+byte* hashmap_slot(ik_hashmap* map, u64 index)
+{
+    return map->slots + index * map->slot_stride;
+}
+
+//the largest power of two up to 8 that divides size, the alignment a key or value gets
+u64 hashmap_alignment(u64 size)
+{
+    u64 alignment = 1;
+    while (alignment < 8 && size % (alignment * 2) == 0) alignment *= 2;
+    return alignment;
+}
+
+//the slot of a key, -1 if it is not in the map. Groups are probed 1, 2, 3... groups apart,
+//which visits every group of a power of two count, and a group with an empty slot ends the search
+i64 hashmap_find(ik_hashmap* map, void* key, u64 hash)
+{
+    if (map->capacity == 0)
+    {
+        return -1;
+    }
+
+    u64 group_mask = map->capacity / HASHMAP_GROUP - 1;
+    u64 group = (hash >> 7) & group_mask;
+    byte control = (byte)(hash & 0x7F);
+    for (u64 step = 1; step <= group_mask + 1; step++)
+    {
+        byte* controls = map->control + group * HASHMAP_GROUP;
+        u32 mask = hashmap_match(controls, control);
+        while (mask)
+        {
+            u64 index = group * HASHMAP_GROUP + math_lowest_bit(mask);
+            if (hashmap_equals(map, hashmap_slot(map, index), key))
+            {
+                return (i64)index;
+            }
+            mask &= mask - 1;
+        }
+        if (hashmap_match(controls, HASHMAP_EMPTY))
+        {
+            return -1;
+        }
+        group = (group + step) & group_mask;
+    }
+    return -1;
+}
+
+//the first empty or deleted slot on the probe path of a hash
+u64 hashmap_find_free(ik_hashmap* map, u64 hash)
+{
+    u64 group_mask = map->capacity / HASHMAP_GROUP - 1;
+    u64 group = (hash >> 7) & group_mask;
+    for (u64 step = 1; ; step++)
+    {
+        u32 mask = hashmap_match_free(map->control + group * HASHMAP_GROUP);
+        if (mask)
+        {
+            return group * HASHMAP_GROUP + math_lowest_bit(mask);
+        }
+        group = (group + step) & group_mask;
+    }
+}
+
+//moves every element into a new block of capacity slots, which also drops the deleted ones
+bool hashmap_rehash(ik_hashmap* map, u64 capacity)
+{
+    byte* block = (byte*)ik_alloc(alloc_hashmap, capacity + capacity * map->slot_stride);
+    if (!block)
+    {
+        return false;
+    }
+
+    ik_hashmap old = *map;
+    map->control = block;
+    map->slots = block + capacity;
+    map->capacity = capacity;
+    map->growth_left = capacity / 8 * 7 - old.size;
+    memset(map->control, HASHMAP_EMPTY, capacity);
+
+    for (u64 i = 0; i < old.capacity; i++)
+    {
+        if (old.control[i] & 0x80) continue;
+
+        byte* slot = hashmap_slot(&old, i);
+        u64 index = hashmap_find_free(map, hashmap_hash(map, slot));
+        map->control[index] = old.control[i];
+        memcpy(hashmap_slot(map, index), slot, map->slot_stride);
+    }
+    ik_free(alloc_hashmap, old.control, old.capacity + old.capacity * old.slot_stride);
+    return true;
+}
+
+void ik_hashmap_make(ik_hashmap* map, u64 key_stride, u64 value_stride, u64 num_elements, hash_callback hash, equals_callback equals)
+{
+    memset(map, 0, sizeof(ik_hashmap));
+    if (0 == key_stride)
+    {
+        return;
+    }
+
+    // the values are aligned to their size within the slot, and so is the next slot
+    u64 value_alignment = value_stride ? hashmap_alignment(value_stride) : 1;
+    u64 slot_alignment = ik_max(hashmap_alignment(key_stride), value_alignment);
+    map->key_stride = key_stride;
+    map->value_stride = value_stride;
+    map->value_offset = (key_stride + value_alignment - 1) / value_alignment * value_alignment;
+    map->slot_stride = (map->value_offset + value_stride + slot_alignment - 1) / slot_alignment * slot_alignment;
+    map->hash = hash;
+    map->equals = equals;
+    ik_hashmap_reserve(map, num_elements);
+}
+
+void ik_hashmap_destroy(ik_hashmap* map)
+{
+    ik_free(alloc_hashmap, map->control, map->capacity + map->capacity * map->slot_stride);
+    memset(map, 0, sizeof(ik_hashmap));
+}
+
+bool ik_hashmap_reserve(ik_hashmap* map, u64 count)
+{
+    // at most 7/8 of the slots are used, so a probe always finds an empty one
+    u64 capacity = HASHMAP_GROUP;
+    while (capacity / 8 * 7 < count) capacity *= 2;
+    if (capacity <= map->capacity)
+    {
+        return true;
+    }
+    return hashmap_rehash(map, capacity);
+}
+
+void* ik_hashmap_insert(ik_hashmap* map, void* key, void* value)
+{
+    if (map->slot_stride == 0)
+    {
+        return 0;
+    }
+
+    u64 hash = hashmap_hash(map, key);
+    i64 found = hashmap_find(map, key, hash);
+    if (found >= 0)
+    {
+        byte* slot = hashmap_slot(map, (u64)found);
+        if (value) memcpy(slot + map->value_offset, value, map->value_stride);
+        return slot + map->value_offset;
+    }
+
+    u64 index = map->capacity ? hashmap_find_free(map, hash) : 0;
+    if (map->capacity == 0 || (map->control[index] == HASHMAP_EMPTY && map->growth_left == 0))
+    {
+        // a map that is mostly deleted slots is cleaned up in place, otherwise it doubles
+        u64 capacity = map->capacity == 0 ? HASHMAP_GROUP :
+            map->size * 16 <= map->capacity * 7 ? map->capacity : map->capacity * 2;
+        if (!hashmap_rehash(map, capacity))
+        {
+            return 0;
+        }
+        index = hashmap_find_free(map, hash);
+    }
+
+    if (map->control[index] == HASHMAP_EMPTY) map->growth_left--;
+    map->control[index] = (byte)(hash & 0x7F);
+    map->size++;
+
+    byte* slot = hashmap_slot(map, index);
+    memcpy(slot, key, map->key_stride);
+    if (value) memcpy(slot + map->value_offset, value, map->value_stride);
+    else memset(slot + map->value_offset, 0, map->value_stride);
+    return slot + map->value_offset;
+}
+
+void* ik_hashmap_get(ik_hashmap* map, void* key)
+{
+    i64 found = hashmap_find(map, key, hashmap_hash(map, key));
+    return found < 0 ? 0 : hashmap_slot(map, (u64)found) + map->value_offset;
+}
+
+bool ik_hashmap_contains(ik_hashmap* map, void* key)
+{
+    return hashmap_find(map, key, hashmap_hash(map, key)) >= 0;
+}
+
+bool ik_hashmap_remove(ik_hashmap* map, void* key)
+{
+    i64 found = hashmap_find(map, key, hashmap_hash(map, key));
+    if (found < 0)
+    {
+        return false;
+    }
+
+    // a search that gets to a group with an empty slot stops there anyway, so the slot can be
+    // empty again. Otherwise a search may have to go past it and it stays deleted.
+    byte* group = map->control + (u64)found / HASHMAP_GROUP * HASHMAP_GROUP;
+    if (hashmap_match(group, HASHMAP_EMPTY))
+    {
+        map->control[found] = HASHMAP_EMPTY;
+        map->growth_left++;
+    }
+    else
+    {
+        map->control[found] = HASHMAP_DELETED;
+    }
+    map->size--;
+    return true;
+}
+
+void ik_hashmap_clear(ik_hashmap* map)
+{
+    if (map->capacity == 0)
+    {
+        return;
+    }
+
+    memset(map->control, HASHMAP_EMPTY, map->capacity);
+    map->size = 0;
+    map->growth_left = map->capacity / 8 * 7;
+}
+
+bool ik_hashmap_next(ik_hashmap* map, u64* iterator, void** key, void** value)
+{
+    for (; *iterator < map->capacity; (*iterator)++)
+    {
+        if (map->control[*iterator] & 0x80) continue;
+
+        byte* slot = hashmap_slot(map, (*iterator)++);
+        if (key) *key = slot;
+        if (value) *value = slot + map->value_offset;
+        return true;
+    }
+    return false;
+}
+
+void ik_hashset_make(ik_hashset* set, u64 key_stride, u64 num_elements, hash_callback hash, equals_callback equals)
+{
+    ik_hashmap_make(set, key_stride, 0, num_elements, hash, equals);
+}
+
+void ik_hashset_destroy(ik_hashset* set)
+{
+    ik_hashmap_destroy(set);
+}
+
+bool ik_hashset_insert(ik_hashset* set, void* key)
+{
+    u64 size = set->size;
+    return ik_hashmap_insert(set, key, 0) && set->size != size;
+}
+
+bool ik_hashset_contains(ik_hashset* set, void* key)
+{
+    return ik_hashmap_contains(set, key);
+}
+
+bool ik_hashset_remove(ik_hashset* set, void* key)
+{
+    return ik_hashmap_remove(set, key);
+}
+
+void ik_hashset_clear(ik_hashset* set)
+{
+    ik_hashmap_clear(set);
+}
+
+bool ik_hashset_next(ik_hashset* set, u64* iterator, void** key)
+{
+    return ik_hashmap_next(set, iterator, key, 0);
+}
+
+#pragma endregion
+
+#pragma region Pool
+
+#define POOL_ALIGNMENT 16
+
+u64* pool_live_bits(byte* block)
+{
+    return (u64*)block;
+}
+
+byte* pool_block_of(ik_pool* pool, void* object)
+{
+    return (byte*)((uintptr_t)object & ~(uintptr_t)(pool->block_size - 1));
+}
+
+//blocks are aligned to their size, so the block of an object is its address rounded down.
+//No ik_allocator can promise that alignment, so blocks come from the heap and are only counted.
+byte* pool_block_alloc(u64 size)
+{
+    alloc_stats[alloc_pool].allocs++;
+    alloc_stats[alloc_pool].bytes += size;
+#ifdef _WIN32
+    return (byte*)_aligned_malloc(size, size);
+#else
+    void* block = 0;
+    return posix_memalign(&block, size, size) == 0 ? (byte*)block : 0;
+#endif
+}
+
+void pool_block_free(byte* block)
+{
+    alloc_stats[alloc_pool].frees++;
+#ifdef _WIN32
+    _aligned_free(block);
+#else
+    free(block);
+#endif
+}
+
+//the size of the live bits in front of the slots, rounded up so the slots stay aligned
+u64 pool_slot_offset(u64 objects)
+{
+    u64 bytes = (objects + 63) / 64 * sizeof(u64);
+    return (bytes + POOL_ALIGNMENT - 1) / POOL_ALIGNMENT * POOL_ALIGNMENT;
+}
+
+void ik_pool_make(ik_pool* pool, u64 stride, u64 objects_per_block)
+{
+    memset(pool, 0, sizeof(ik_pool));
+    if (0 == stride)
+    {
+        return;
+    }
+
+    // a free slot holds the link to the next one, so it is at least a pointer
+    pool->stride = stride;
+    pool->slot_stride = (ik_max(stride, sizeof(void*)) + sizeof(void*) - 1) / sizeof(void*) * sizeof(void*);
+    objects_per_block = ik_max(objects_per_block, 1);
+
+    pool->block_size = 256;
+    while (pool->block_size < pool_slot_offset(objects_per_block) + objects_per_block * pool->slot_stride)
+    {
+        pool->block_size *= 2;
+    }
+    u64 objects = (pool->block_size - pool_slot_offset(1)) / pool->slot_stride;
+    while (pool_slot_offset(objects) + objects * pool->slot_stride > pool->block_size) objects--;
+    pool->objects_per_block = objects;
+    pool->slot_offset = pool_slot_offset(objects);
+    array_make(&pool->blocks, sizeof(byte*), 4, 0, alloc_pool);
+}
+
+void ik_pool_destroy(ik_pool* pool)
+{
+    for (u64 i = 0; i < pool->blocks.size; i++)
+    {
+        pool_block_free(((byte**)pool->blocks.data)[i]);
+    }
+    ik_array_destroy(&pool->blocks);
+    memset(pool, 0, sizeof(ik_pool));
+}
+
+//links the slots of blocks[first...] into the free list, so they are handed out in address order
+void pool_link_free(ik_pool* pool, u64 first)
+{
+    for (u64 b = pool->blocks.size; b-- > first;)
+    {
+        byte* block = ((byte**)pool->blocks.data)[b];
+        memset(pool_live_bits(block), 0, pool->slot_offset);
+        for (u64 i = pool->objects_per_block; i-- > 0;)
+        {
+            byte* slot = block + pool->slot_offset + i * pool->slot_stride;
+            memcpy(slot, &pool->free_list, sizeof(byte*));
+            pool->free_list = slot;
+        }
+    }
+}
+
+void* ik_pool_alloc(ik_pool* pool)
+{
+    if (!pool->free_list)
+    {
+        if (pool->stride == 0)
+        {
+            return 0;
+        }
+
+        byte* block = pool_block_alloc(pool->block_size);
+        if (!block)
+        {
+            return 0;
+        }
+        ik_array_append(&pool->blocks, &block);
+        if (((byte**)pool->blocks.data)[pool->blocks.size - 1] != block)
+        {
+            pool_block_free(block);
+            return 0;
+        }
+        pool_link_free(pool, pool->blocks.size - 1);
+    }
+
+    byte* slot = pool->free_list;
+    memcpy(&pool->free_list, slot, sizeof(byte*));
+
+    byte* block = pool_block_of(pool, slot);
+    u64 index = (slot - block - pool->slot_offset) / pool->slot_stride;
+    pool_live_bits(block)[index / 64] |= 1ull << (index % 64);
+    pool->size++;
+
+    memset(slot, 0, pool->stride);
+    return slot;
+}
+
+void ik_pool_free(ik_pool* pool, void* object)
+{
+    if (!object)
+    {
+        return;
+    }
+
+    byte* block = pool_block_of(pool, object);
+    u64 index = ((byte*)object - block - pool->slot_offset) / pool->slot_stride;
+    u64 bit = 1ull << (index % 64);
+    if (!(pool_live_bits(block)[index / 64] & bit))
+    {
+        return;
+    }
+
+    pool_live_bits(block)[index / 64] &= ~bit;
+    memcpy(object, &pool->free_list, sizeof(byte*));
+    pool->free_list = (byte*)object;
+    pool->size--;
+}
+
+void ik_pool_clear(ik_pool* pool)
+{
+    pool->free_list = 0;
+    pool->size = 0;
+    pool_link_free(pool, 0);
+}
+
+bool ik_pool_next(ik_pool* pool, u64* iterator, void** object)
+{
+    // the iterator is the number of slots before the next one to look at, the live bits skip
+    // 64 free slots at a time
+    while (*iterator < pool->blocks.size * pool->objects_per_block)
+    {
+        u64 b = *iterator / pool->objects_per_block;
+        u64 i = *iterator % pool->objects_per_block;
+        byte* block = ((byte**)pool->blocks.data)[b];
+
+        u64 word = pool_live_bits(block)[i / 64] & (~0ull << (i % 64));
+        if (!word)
+        {
+            u64 next = (i / 64 + 1) * 64;
+            *iterator = b * pool->objects_per_block + ik_min(next, pool->objects_per_block);
+            continue;
+        }
+
+        u64 index = i / 64 * 64 + math_lowest_bit64(word);
+        *object = block + pool->slot_offset + index * pool->slot_stride;
+        *iterator = b * pool->objects_per_block + index + 1;
+        return true;
+    }
+    return false;
+}
+
+#pragma endregion
+
+#pragma region Parsers
+
+i32 ik_parser_comma_index(char *text)
+{
+    for (i32 i = 0; i < strlen(text); i++)
+    {
+        if (text[i] == ',')
+        {
+            return i;
+        }
+    }
+    return -1;
+}
+
+u64 ik_parser_decimal_count(char *text, i32 comma_index)
+{
+    return strlen(text) - 1 - comma_index;
+}
+
+bool ik_parser_parse_as_int(ik_string *text, int *out_number)
+{
+    *out_number = 0;
+
+    // check if text is null
+    if (text == 0)
+    {
+        return 0;
+    }
+
+    ik_string fixed_comma = {};
+    ik_string_make(&fixed_comma, text->cstring);
+    ik_string comma = { };
+    ik_string_make(&comma, ",");
+    ik_string dot = { };
+    ik_string_make(&dot, ".");
+    ik_string_replace(&fixed_comma, (&comma)->cstring, (&dot)->cstring);
+
+    if (ik_is_numeric(text->cstring))
+        ik_round_to_int(atof(fixed_comma.cstring), out_number);
+    else
+        return false;
+    return true;
+}
+
+bool ik_parser_parse_as_float(ik_string *text, float *out_number)
+{
+    *out_number = 0;
+
+    // check if text is null
+    if (text == 0)
+    {
+        return 0;
+    }
+
+    ik_string fixed_comma = {};
+    ik_string_make(&fixed_comma, text->cstring);
+
+    ik_string comma = { };
+    ik_string_make(&comma, ",");
+    ik_string dot = { };
+    ik_string_make(&dot, ".");
+    ik_string_replace(&fixed_comma, (&comma)->cstring, (&dot)->cstring);
+
+
+    if (!ik_is_numeric(text->cstring))
+        return false;
+    float out = (float)atof(fixed_comma.cstring);
+    *out_number = out;
+    return true;
+}
+
+#pragma endregion
+
+#pragma region Random
+
+void ik_random_init(ik_random* state, u32 seed) 
+{
+    u32* state_array = &(state->state_array[0]);
+    
+    state_array[0] = seed; // suggested initial seed = 19650218UL
+    
+    for (int i=1; i<624; i++)
+    {
+        seed = 1812433253UL * (seed ^ (seed >> (32-2))) + i; 
+        state_array[i] = seed; 
+    }
+    
+    state->state_index = 0;
+}
+
+
+void ik_random_next(ik_random* state, i32* out)
+{
+    u32* state_array = &(state->state_array[0]);
+    
+    int k = state->state_index;      
+    int j = k - (624-1);               
+    if (j < 0) j += 624;               
+
+    u32 x = (state_array[k] & (0xffffffffUL << 31)) | (state_array[j] & (0xffffffffUL >> (32-31)));
+    
+    u32 xA = x >> 1;
+    if (x & 0x00000001UL) xA ^= 0x9908b0dfUL;
+    
+    j = k - (624-397);
+    if (j < 0) j += 624;
+    
+    x = state_array[j] ^ xA;
+    state_array[k++] = x;
+    
+    if (k >= 624) k = 0;
+    state->state_index = k;
+    
+    u32 y = x ^ (x >> 11);
+            y = y ^ ((y << 7) & 0x9d2c5680UL);
+            y = y ^ ((y << 15) & 0xefc60000UL);
+    u32 z = y ^ (y >> 18);
+    
+    *out = z; 
+}
+
+#pragma endregion
+
+#pragma region Comparator
+
+bool ik_compare_string(void* a, void* b)
+{
+    u64 upper_limit = ik_min(((ik_string*)a)->size, ((ik_string*)b)->size);
+    ik_string _a;
+    ik_string _b;
+
+    memset(&_a, '\0', sizeof(ik_string));
+    memset(&_b, '\0', sizeof(ik_string));
+
+    ik_string_make(&_a, ((ik_string*)a)->cstring);
+    ik_string_make(&_b, ((ik_string*)b)->cstring);
+
+    ik_to_lower(_a.cstring);
+    ik_to_lower(_b.cstring);
+
+    for (int i = 0; i < upper_limit; i++)
+    {
+        if (_a.cstring[i] == _b.cstring[i])
+        {
+            continue;
+        }
+
+        bool ret = _a.cstring[i] > _b.cstring[i];
+        ik_string_destroy(&_a);
+        ik_string_destroy(&_b);
+
+        return ret;
+    }
+    return false;
+}
+bool ik_compare_i32(void* a, void* b)
+{
+    i32 _a = *(i32*)a;
+    i32 _b = *(i32*)b;
+
+	return _a > _b;
+}
+bool ik_compare_u32(void* a, void* b)
+{
+	u32 _a = *(u32*)a;
+	u32 _b = *(u32*)b;
+
+	return _a > _b;
+}
+bool ik_compare_i64(void* a, void* b)
+{
+	i64 _a = *(i64*)a;
+	i64 _b = *(i64*)b;
+
+	return _a > _b;
+}
+bool ik_compare_u64(void* a, void* b)
+{
+	u64 _a = *(u64*)a;
+	u64 _b = *(u64*)b;
+
+	return _a > _b;
+}
+bool ik_compare_f32(void* a, void* b)
+{
+	float _a = *(float*)a;
+	float _b = *(float*)b;
+
+	return _a > _b;
+}
+bool ik_compare_f64(void* a, void* b)
+{
+	double _a = *(double*)a;
+	double _b = *(double*)b;
+
+	return _a > _b;
+}
+bool ik_compare_byte(void* a, void* b)
+{
+	byte _a = *(byte*)a;
+	byte _b = *(byte*)b;
+
+	return _a > _b;
+}
+
+#pragma endregion
+
+#pragma region Screen
+u8 SCREEN_WIDTH, SCREEN_HEIGHT = 0; 
+char SCREEN_BACKGROUND = ' ';
+ik_array SCREEN_BUFFER = {};
+bool SCREEN_UPDATE = false;
+bool screen_headless = false;       // frames are built but not written or paced
+int TICKRATE = 0;
+
+#ifndef ENABLE_VIRTUAL_TERMINAL_PROCESSING
+#   define ENABLE_VIRTUAL_TERMINAL_PROCESSING 0x0004
+#endif
+
+// spans smaller than this are written directly, bucketing them by row costs more than it saves
+#define SCREEN_SPAN_BUCKET_MIN 64
+
+ik_array screen_output = {};        // bytes of the frame currently being built
+ik_array screen_front = {};         // cells as the terminal shows them after the last presented frame
+bool screen_front_valid = false;
+ik_color_mode screen_front_mode = color_mode_truecolor;
+ik_array screen_span_order = {};    // u32 pixel indices, sorted by row
+ik_array screen_span_rows = {};     // u8 row bucket per pixel, SCREEN_HEIGHT means clipped
+
+//helper functions
+ik_cell *GET_PIXEL(int x, int y) {
+    return (ik_cell*)SCREEN_BUFFER.data + y * SCREEN_WIDTH + x;
+}
+
+void screen_reserve(ik_array* scratch, u64 count) {
+    if (scratch->capacity < count)
+    {
+        // doubling keeps a frame that outgrows the buffer from reallocating on every write
+        ik_array_reserve(scratch, ik_max(count, scratch->capacity * 2));
+    }
+}
+
+void screen_write(const char* bytes, u64 len) {
+    screen_reserve(&screen_output, screen_output.size + len);
+    memcpy((byte*)screen_output.data + screen_output.size, bytes, len);
+    screen_output.size += len;
+}
+
+// a UTF-8 character plus its trailing combining marks
+typedef struct {
+    char _utf8[14];
+    u8 _size;
+    u8 _width;
+} screen_glyph;
+
+// ids below this are raw bytes, interned glyphs are numbered from here on
+#define GLYPH_FIRST_ID 256
+#define GLYPH_SLOTS 8192
+#define GLYPH_MAX (GLYPH_SLOTS / 2)
+
+ik_array glyph_table = {};          // screen_glyph entries, index + GLYPH_FIRST_ID is the id
+u16 glyph_slots[GLYPH_SLOTS] = {};  // open addressing on the utf8 bytes, 0 is empty
+
+//decodes one UTF-8 sequence, invalid input decodes to U+FFFD with a length of 1
+u32 utf8_decode(const char* text, u32* out_len) {
+    const u8* s = (const u8*)text;
+    u32 len = 1, cp = s[0];
+    if (cp >= 0xF0 && cp < 0xF8) { len = 4; cp &= 0x07; }
+    else if (cp >= 0xE0) { len = 3; cp &= 0x0F; }
+    else if (cp >= 0xC2) { len = 2; cp &= 0x1F; }
+    else if (cp >= 0x80) { *out_len = 1; return 0xFFFD; }
+
+    for (u32 i = 1; i < len; i++)
+    {
+        if ((s[i] & 0xC0) != 0x80) { *out_len = 1; return 0xFFFD; }
+        cp = (cp << 6) | (s[i] & 0x3F);
+    }
+    *out_len = len;
+    return cp;
+}
+
+//encodes a codepoint as UTF-8, returns the amount of bytes written to out
+u32 utf8_encode(u32 cp, char* out) {
+    if (cp < 0x80)
+    {
+        out[0] = (char)cp;
+        return 1;
+    }
+    if (cp < 0x800)
+    {
+        out[0] = (char)(0xC0 | (cp >> 6));
+        out[1] = (char)(0x80 | (cp & 0x3F));
+        return 2;
+    }
+    if (cp < 0x10000)
+    {
+        out[0] = (char)(0xE0 | (cp >> 12));
+        out[1] = (char)(0x80 | ((cp >> 6) & 0x3F));
+        out[2] = (char)(0x80 | (cp & 0x3F));
+        return 3;
+    }
+    out[0] = (char)(0xF0 | (cp >> 18));
+    out[1] = (char)(0x80 | ((cp >> 12) & 0x3F));
+    out[2] = (char)(0x80 | ((cp >> 6) & 0x3F));
+    out[3] = (char)(0x80 | (cp & 0x3F));
+    return 4;
+}
+
+bool utf8_is_combining(u32 cp) {
+    return (cp >= 0x0300 && cp <= 0x036F) || (cp >= 0x200B && cp <= 0x200F) ||
+           (cp >= 0x20D0 && cp <= 0x20FF) || (cp >= 0xFE00 && cp <= 0xFE0F);
+}
+
+//east asian wide and fullwidth ranges plus the emoji blocks terminals draw two columns wide
+u8 utf8_width(u32 cp) {
+    static const u32 wide[][2] = {
+        { 0x1100, 0x115F }, { 0x231A, 0x231B }, { 0x23E9, 0x23EC }, { 0x2614, 0x2615 },
+        { 0x2E80, 0x303E }, { 0x3041, 0x33FF }, { 0x3400, 0x4DBF }, { 0x4E00, 0x9FFF },
+        { 0xA000, 0xA4CF }, { 0xAC00, 0xD7A3 }, { 0xF900, 0xFAFF }, { 0xFE30, 0xFE4F },
+        { 0xFF00, 0xFF60 }, { 0xFFE0, 0xFFE6 }, { 0x1F300, 0x1F64F }, { 0x1F680, 0x1F6FF },
+        { 0x1F900, 0x1F9FF }, { 0x20000, 0x2FFFD }, { 0x30000, 0x3FFFD },
+    };
+    if (cp < wide[0][0]) return 1;
+    for (size_t i = 0; i < sizeof(wide) / sizeof(wide[0]); i++)
+    {
+        if (cp < wide[i][0]) return 1;
+        if (cp <= wide[i][1]) return 2;
+    }
+    return 1;
+}
+
+screen_glyph* glyph_at(u16 glyph) {
+    return (screen_glyph*)glyph_table.data + (glyph - GLYPH_FIRST_ID);
+}
+
+//true for single byte characters and ids handed out by glyph_intern_next
+bool glyph_known(u16 glyph) {
+    return glyph < GLYPH_FIRST_ID || (u64)(glyph - GLYPH_FIRST_ID) < glyph_table.size;
+}
+
+//interns the character at text, out_len receives the amount of bytes it spans
+u16 glyph_intern_next(const char* text, u32* out_len) {
+    u32 len = 0;
+    u32 cp = utf8_decode(text, &len);
+    if (cp < 0x80 && (u8)text[1] < 0x80)
+    {
+        *out_len = 1;
+        return (u16)cp;
+    }
+
+    u32 size = len;
+    while (text[size] != '\0')
+    {
+        u32 next_len = 0;
+        u32 next = utf8_decode(text + size, &next_len);
+        if (!utf8_is_combining(next) || size + next_len > sizeof(((screen_glyph*)0)->_utf8)) break;
+        size += next_len;
+    }
+    *out_len = size;
+    if (cp < 0x80 && size == 1) return (u16)cp;
+    if (cp == 0xFFFD && len == 1) return '?';
+
+    u32 hash = 2166136261u;
+    for (u32 i = 0; i < size; i++)
+    {
+        hash = (hash ^ (u8)text[i]) * 16777619u;
+    }
+
+    if (!glyph_table.stride) array_make(&glyph_table, sizeof(screen_glyph), 64, 0, alloc_screen);
+
+    u32 slot = hash & (GLYPH_SLOTS - 1);
+    while (glyph_slots[slot] != 0)
+    {
+        screen_glyph* g = glyph_at(glyph_slots[slot]);
+        if (g->_size == size && memcmp(g->_utf8, text, size) == 0) return glyph_slots[slot];
+        slot = (slot + 1) & (GLYPH_SLOTS - 1);
+    }
+    if (glyph_table.size >= GLYPH_MAX) return '?';
+
+    screen_glyph g = { };
+    memcpy(g._utf8, text, size);
+    g._size = (u8)size;
+    g._width = utf8_width(cp);
+    ik_array_append(&glyph_table, &g);
+
+    u16 id = (u16)(GLYPH_FIRST_ID + glyph_table.size - 1);
+    glyph_slots[slot] = id;
+    return id;
+}
+
+//writes a glyph into a row and repairs double-width glyphs it overlaps
+void screen_put(ik_cell* row, u32 x, u16 glyph, ik_color foreground, ik_color background) {
+    // a tail on its own would orphan the cell, an id that was never interned has nothing to print
+    if (glyph == IK_GLYPH_WIDE_TAIL) return;
+    if (!glyph_known(glyph)) glyph = '?';
+
+    ik_cell* c = row + x;
+    u32 width = SCREEN_WIDTH;
+    u8 span = glyph < GLYPH_FIRST_ID ? 1 : glyph_at(glyph)->_width;
+
+    if (span == 2 && x + 1 >= width)
+    {
+        glyph = ' ';
+        span = 1;
+    }
+    if (c->_glyph == IK_GLYPH_WIDE_TAIL && x > 0) c[-1]._glyph = ' ';
+    if (x + span < width && c[span]._glyph == IK_GLYPH_WIDE_TAIL) c[span]._glyph = ' ';
+
+    c->_glyph = glyph;
+    c->_foreground = foreground;
+    c->_background = background;
+    if (span == 2)
+    {
+        c[1]._glyph = IK_GLYPH_WIDE_TAIL;
+        c[1]._foreground = foreground;
+        c[1]._background = background;
+    }
+}
+
+//maps a basic color to its SGR parameter, backgrounds are offset by 10
+int screen_sgr_code(u8 c, bool background) {
+    int code = 39;
+    if (c >= black && c <= light_gray) code = 29 + c;
+    else if (c >= dark_gray && c <= white) code = 81 + c;
+    return code + background * 10;
+}
+
+ik_color_mode SCREEN_COLOR_MODE = color_mode_truecolor;    // what the session asked for
+ik_color_mode screen_color_mode = color_mode_truecolor;    // what frames are written with
+bool screen_color_adaptive = false;
+u32 screen_link_strained = 0;
+u32 screen_link_calm = 0;
+ik_screen_stats screen_stats = {};
+
+// lookup tables for mapping colors down, filled on first use
+bool color_tables_ready = false;
+u8 color_cube_level[256];       // channel value -> nearest of the 6 cube levels
+u8 color_gray_level[256];       // channel average -> nearest of the 24 gray ramp steps
+u8 color_palette_to_16[256];    // 256-color index -> basic color value
+u8 color_palette_rgb[256][3];
+
+void color_tables_init() {
+    static const u8 basic[16][3] = {
+        { 0, 0, 0 }, { 205, 0, 0 }, { 0, 205, 0 }, { 205, 205, 0 },
+        { 0, 0, 238 }, { 205, 0, 205 }, { 0, 205, 205 }, { 229, 229, 229 },
+        { 127, 127, 127 }, { 255, 0, 0 }, { 0, 255, 0 }, { 255, 255, 0 },
+        { 92, 92, 255 }, { 255, 0, 255 }, { 0, 255, 255 }, { 255, 255, 255 },
+    };
+    static const u8 cube[6] = { 0, 95, 135, 175, 215, 255 };
+
+    for (int i = 0; i < 256; i++)
+    {
+        u8* rgb = color_palette_rgb[i];
+        if (i < 16) memcpy(rgb, basic[i], 3);
+        else if (i < 232)
+        {
+            rgb[0] = cube[(i - 16) / 36];
+            rgb[1] = cube[(i - 16) / 6 % 6];
+            rgb[2] = cube[(i - 16) % 6];
+        }
+        else memset(rgb, 8 + (i - 232) * 10, 3);
+
+        color_cube_level[i] = i < 48 ? 0 : i < 115 ? 1 : (u8)((i - 35) / 40);
+        color_gray_level[i] = i < 8 ? 0 : i > 238 ? 23 : (u8)((i - 3) / 10);
+    }
+
+    // basic colors are 1 based, palette entry n is the basic color n + 1
+    for (int i = 0; i < 256; i++)
+    {
+        if (i < 16)
+        {
+            color_palette_to_16[i] = (u8)(i + 1);
+            continue;
+        }
+        i32 best = 0x7FFFFFFF;
+        for (int j = 0; j < 16; j++)
+        {
+            i32 dr = color_palette_rgb[i][0] - basic[j][0];
+            i32 dg = color_palette_rgb[i][1] - basic[j][1];
+            i32 db = color_palette_rgb[i][2] - basic[j][2];
+            i32 d = dr * dr + dg * dg + db * db;
+            if (d < best)
+            {
+                best = d;
+                color_palette_to_16[i] = (u8)(j + 1);
+            }
+        }
+    }
+    color_tables_ready = true;
+}
+
+u8 color_rgb_to_256(u8 r, u8 g, u8 b) {
+    u8 cr = color_cube_level[r], cg = color_cube_level[g], cb = color_cube_level[b];
+    u8 cube = (u8)(16 + 36 * cr + 6 * cg + cb);
+    u8 gray = (u8)(232 + color_gray_level[(r + g + b) / 3]);
+
+    i32 d_cube = 0, d_gray = 0;
+    u8 in[3] = { r, g, b };
+    for (int i = 0; i < 3; i++)
+    {
+        i32 dc = in[i] - color_palette_rgb[cube][i];
+        i32 dg = in[i] - color_palette_rgb[gray][i];
+        d_cube += dc * dc;
+        d_gray += dg * dg;
+    }
+    return d_gray < d_cube ? gray : cube;
+}
+
+//maps a color down until the given mode can show it
+ik_color color_downgrade(ik_color c, ik_color_mode mode) {
+    if (c & IK_COLOR_TAG_RGB)
+    {
+        if (mode == color_mode_truecolor) return c;
+        c = ik_color_256(color_rgb_to_256((u8)(c >> 16), (u8)(c >> 8), (u8)c));
+    }
+    if ((c & IK_COLOR_TAG_256) && mode == color_mode_16) return color_palette_to_16[(u8)c];
+    return c;
+}
+
+//writes the SGR parameters of one color without the leading escape
+int color_sgr(char* out, ik_color c, bool background) {
+    if (c & IK_COLOR_TAG_RGB)
+        return sprintf(out, "%i;2;%i;%i;%i", 38 + background * 10, (u8)(c >> 16), (u8)(c >> 8), (u8)c);
+    if (c & IK_COLOR_TAG_256)
+        return sprintf(out, "%i;5;%i", 38 + background * 10, (u8)c);
+    return sprintf(out, "%i", screen_sgr_code((u8)c, background));
+}
+
+//steps the adaptive color mode down while writes eat the frame budget, and back up when calm
+void screen_adapt_color_mode(i64 write_us) {
+    i64 budget_us = TICKRATE > 0 ? 1000000 / TICKRATE : 1000000 / 60;
+
+    if (write_us * 2 > budget_us)
+    {
+        screen_link_calm = 0;
+        if (++screen_link_strained >= 3 && screen_color_mode > color_mode_16)
+        {
+            screen_color_mode = (ik_color_mode)(screen_color_mode - 1);
+            screen_stats.color_downgrades++;
+            screen_link_strained = 0;
+        }
+    }
+    else if (write_us * 8 < budget_us)
+    {
+        screen_link_strained = 0;
+        if (++screen_link_calm >= 60 && screen_color_mode < SCREEN_COLOR_MODE)
+        {
+            screen_color_mode = (ik_color_mode)(screen_color_mode + 1);
+            screen_link_calm = 0;
+        }
+    }
+    else
+    {
+        screen_link_strained = 0;
+        screen_link_calm = 0;
+    }
+}
+//end !helper functions
+
+// input latency, every input event is stamped when it arrives, when ik_update_input takes it and when
+// the first frame that can show it is presented. The frame's last byte reaching the terminal ends it.
+#define LATENCY_STAMPS 256
+#define LATENCY_STAGES 4
+#define LATENCY_BUCKETS 272                     // 16 exact buckets, then 8 per power of two up to 2^36 us
+#define LATENCY_UNASSIGNED ((u64)-1)
+
+typedef struct {
+    i64 arrival, update, print;
+    u64 frame_end;                              // offset in the output queue the frame ends at
+} latency_stamp;
+
+latency_stamp latency_stamps[LATENCY_STAMPS];
+u32 latency_stamp_count = 0;
+u64 latency_histogram[LATENCY_STAGES][LATENCY_BUCKETS] = {};
+u64 latency_samples[LATENCY_STAGES] = {};
+i64 latency_min[LATENCY_STAGES] = {};
+i64 latency_max[LATENCY_STAGES] = {};
+i64 latency_sum[LATENCY_STAGES] = {};
+
+u32 latency_highest_bit(u64 value) {
+#ifdef _MSC_VER
+    unsigned long index;
+    _BitScanReverse64(&index, value);
+    return index;
+#else
+    return 63 - (u32)__builtin_clzll(value);
+#endif
+}
+
+u32 latency_bucket(i64 us) {
+    if (us < 16) return (u32)ik_max(us, 0);
+    u32 msb = latency_highest_bit((u64)us);
+    u32 bucket = 16 + (msb - 4) * 8 + (u32)((us >> (msb - 3)) & 7);
+    return (u32)ik_min(bucket, LATENCY_BUCKETS - 1);
+}
+
+//the largest value that falls into a bucket
+i64 latency_bucket_limit(u32 bucket) {
+    if (bucket < 16) return bucket;
+    u32 msb = (bucket - 16) / 8 + 4;
+    return ((i64)(8 + (bucket - 16) % 8 + 1) << (msb - 3)) - 1;
+}
+
+void latency_record(u32 stage, i64 us) {
+    if (us < 0) us = 0;
+    latency_histogram[stage][latency_bucket(us)]++;
+    if (latency_samples[stage] == 0 || us < latency_min[stage]) latency_min[stage] = us;
+    if (us > latency_max[stage]) latency_max[stage] = us;
+    latency_sum[stage] += us;
+    latency_samples[stage]++;
+}
+
+//called by ik_update_input for every event it takes
+void screen_latency_stamp(i64 arrival, i64 update) {
+    if (latency_stamp_count == LATENCY_STAMPS) return;
+    latency_stamps[latency_stamp_count++] = { arrival, update, 0, LATENCY_UNASSIGNED };
+}
+
+//the frame being presented carries every stamp no frame has yet, it ends at frame_end in the queue
+void screen_latency_present(i64 print, u64 frame_end) {
+    for (u32 i = 0; i < latency_stamp_count; i++)
+    {
+        latency_stamp* stamp = latency_stamps + i;
+        if (stamp->frame_end != LATENCY_UNASSIGNED) continue;
+        if (stamp->print == 0) stamp->print = print;
+        stamp->frame_end = frame_end;
+    }
+}
+
+//the frames up to offset written reached the terminal
+void screen_latency_written(u64 written, i64 now) {
+    u32 kept = 0;
+    for (u32 i = 0; i < latency_stamp_count; i++)
+    {
+        latency_stamp* stamp = latency_stamps + i;
+        if (stamp->frame_end == LATENCY_UNASSIGNED || stamp->frame_end > written)
+        {
+            latency_stamps[kept++] = *stamp;
+            continue;
+        }
+        latency_record(latency_total, now - stamp->arrival);
+        latency_record(latency_input, stamp->update - stamp->arrival);
+        latency_record(latency_logic, stamp->print - stamp->update);
+        latency_record(latency_output, now - stamp->print);
+    }
+    latency_stamp_count = kept;
+}
+
+//a frame that was dropped before it was written gives its stamps to the next one
+void screen_latency_unassign(u64 from) {
+    for (u32 i = 0; i < latency_stamp_count; i++)
+    {
+        if (latency_stamps[i].frame_end != LATENCY_UNASSIGNED && latency_stamps[i].frame_end > from)
+            latency_stamps[i].frame_end = LATENCY_UNASSIGNED;
+    }
+}
+
+
+#ifndef _WIN32
+// non-blocking output queue, it holds the rest of the frame being written plus at most one frame
+// that has not been started. A newer frame replaces an unstarted one instead of queueing behind it.
+int screen_fd = -1;                 // own non-blocking description of the terminal, -1 writes block
+ik_array screen_pending = {};       // bytes queued for the terminal
+u64 screen_pending_sent = 0;        // bytes of screen_pending already written
+u64 screen_pending_started = 0;     // end of the frame that is partially written
+ik_array screen_committed = {};     // cells as the terminal shows them once the started frame is written
+ik_color_mode screen_committed_mode = color_mode_truecolor;
+bool screen_output_congested = false;
+
+//writes as much of the queue as the terminal takes, returns the amount of bytes written
+u64 screen_flush_pending() {
+    u64 written = 0;
+    while (screen_pending_sent < screen_pending.size)
+    {
+        ssize_t n = write(screen_fd, (byte*)screen_pending.data + screen_pending_sent, screen_pending.size - screen_pending_sent);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) break;
+
+        screen_pending_sent += n;
+        written += n;
+        if (screen_pending_sent > screen_pending_started)
+        {
+            // the queued frame is on its way now, it can't be replaced anymore
+            screen_pending_started = screen_pending.size;
+            memcpy(screen_committed.data, screen_front.data, screen_front.size * sizeof(ik_cell));
+            screen_committed_mode = screen_front_mode;
+        }
+    }
+    if (written > 0) screen_latency_written(screen_pending_sent, ik_time_now_us());
+    if (screen_pending_sent == screen_pending.size)
+    {
+        screen_pending.size = 0;
+        screen_pending_sent = 0;
+        screen_pending_started = 0;
+    }
+    screen_output_congested = screen_pending.size != 0;
+    return written;
+}
+
+//keeps writing the queue while waiting for the deadline
+void screen_flush_until(i64 deadline) {
+    i64 now = ik_time_now_us();
+    while (screen_pending.size != 0 && now < deadline)
+    {
+        struct pollfd pfd = { screen_fd, POLLOUT, 0 };
+        if (poll(&pfd, 1, (int)((deadline - now + 999) / 1000)) > 0) screen_flush_pending();
+        now = ik_time_now_us();
+    }
+}
+
+//drops a frame that has not been started, the next frame is then built against what it would have replaced
+bool screen_merge_stale_frame() {
+    if (screen_pending.size <= screen_pending_started) return false;
+
+    screen_latency_unassign(screen_pending_started);
+    screen_pending.size = screen_pending_started;
+    memcpy(screen_front.data, screen_committed.data, screen_front.size * sizeof(ik_cell));
+    screen_front_mode = screen_committed_mode;
+    return true;
+}
+
+//blocks until everything queued reached the terminal, used at exit
+void screen_output_drain() {
+    if (screen_fd < 0) return;
+    fcntl(screen_fd, F_SETFL, fcntl(screen_fd, F_GETFL) & ~O_NONBLOCK);
+    screen_flush_pending();
+    close(screen_fd);
+    screen_fd = -1;
+}
+
+void screen_output_open() {
+    if (screen_fd >= 0) return;
+
+    // only a terminal can be opened a second time safely, a file or pipe would get its own offset and
+    // overwrite what printf wrote, so those keep going through stdout
+    if (!isatty(STDOUT_FILENO)) return;
+
+    // a separate open file description, so stdout itself stays blocking for printf
+    const char* path = ttyname(STDOUT_FILENO);
+    if (!path) return;
+    screen_fd = open(path, O_WRONLY | O_NONBLOCK | O_NOCTTY);
+    if (screen_fd < 0) return;
+
+    if (!screen_pending.stride) array_make(&screen_pending, sizeof(char), screen_output.capacity * 2, 0, alloc_screen);
+    atexit(screen_output_drain);
+}
+#endif
+
+void ik_screen_init(u8 width, u8 height, char background, int max_tick_rate){
+    SCREEN_WIDTH = width;
+    SCREEN_HEIGHT = height;
+    SCREEN_BACKGROUND = background;
+    TICKRATE = max_tick_rate;
+    array_make(&SCREEN_BUFFER, sizeof(ik_cell), height * width, 0, alloc_screen);
+    SCREEN_BUFFER.size = SCREEN_BUFFER.capacity;
+    ik_screen_clear_screen();
+
+    if (!screen_output.stride) array_make(&screen_output, sizeof(char), (u64)width * height * 8, 0, alloc_screen);
+    if (!screen_span_order.stride) array_make(&screen_span_order, sizeof(u32), 256, 0, alloc_screen);
+    if (!screen_span_rows.stride) array_make(&screen_span_rows, sizeof(u8), 256, 0, alloc_screen);
+    if (screen_front.stride) ik_array_destroy(&screen_front);
+    array_make(&screen_front, sizeof(ik_cell), height * width, 0, alloc_screen);
+    screen_front.size = screen_front.capacity;
+    screen_front_valid = false;
+#ifndef _WIN32
+    if (screen_committed.stride) ik_array_destroy(&screen_committed);
+    array_make(&screen_committed, sizeof(ik_cell), height * width, 0, alloc_screen);
+    screen_committed.size = screen_committed.capacity;
+#endif
+
+#ifdef _WIN32
+    // the frame is emitted as VT sequences, which conhost only understands when asked to
+    HANDLE hConsole = GetStdHandle(STD_OUTPUT_HANDLE);
+    DWORD mode = 0;
+    if (GetConsoleMode(hConsole, &mode))
+        SetConsoleMode(hConsole, mode | ENABLE_VIRTUAL_TERMINAL_PROCESSING);
+#endif
+    if (!screen_headless)
+    {
+        ik_clrscr();
+        printf("\n");
+        fflush(stdout);
+    }
+#ifndef _WIN32
+    if (!screen_headless) screen_output_open();
+#endif
+    SCREEN_UPDATE = true;
+}
+
+void ik_screen_set_pixels(ik_array pixels){
+    pixel* _pixels = (pixel*)pixels.data;
+    for (size_t i = 0; i < pixels.size; i++)
+    {
+        pixel *_curr = _pixels + i;
+        ik_screen_set_pixel(_curr->_x, _curr->_y, _curr->_char, _curr->_foreground, _curr->_background);
+    }
+}
+
+void ik_screen_set_pixel_span(const compact_pixel* pixels, u64 count){
+    if (pixels == 0 || count == 0 || SCREEN_BUFFER.data == 0) return;
+
+    const u32 width = SCREEN_WIDTH;
+    const u32 height = SCREEN_HEIGHT;
+    ik_cell* cells = (ik_cell*)SCREEN_BUFFER.data;
+
+    if (count < SCREEN_SPAN_BUCKET_MIN)
+    {
+        for (u64 i = 0; i < count; i++)
+        {
+            const compact_pixel* p = pixels + i;
+            if (p->_x >= width || p->_y >= height) continue;
+            screen_put(cells + p->_y * width, p->_x, p->_glyph, p->_foreground, p->_background);
+        }
+        return;
+    }
+
+    screen_reserve(&screen_span_rows, count);
+    screen_reserve(&screen_span_order, count);
+    u8* rows = (u8*)screen_span_rows.data;
+    u32* order = (u32*)screen_span_order.data;
+
+    // clipping pre-pass: branch-free, every pixel gets its row or the discard bucket
+    for (u64 i = 0; i < count; i++)
+    {
+        u32 x = pixels[i]._x;
+        u32 y = pixels[i]._y;
+        u32 inside = (x < width) & (y < height);
+        rows[i] = (u8)(inside * y + (1 - inside) * height);
+    }
+
+    // counting sort by row, stable so that the last write to a cell still wins
+    u32 offsets[257] = { };
+    for (u64 i = 0; i < count; i++)
+    {
+        offsets[rows[i] + 1]++;
+    }
+    for (u32 y = 0; y < height; y++)
+    {
+        offsets[y + 1] += offsets[y];
+    }
+    for (u64 i = 0; i < count; i++)
+    {
+        u8 y = rows[i];
+        if (y < height) order[offsets[y]++] = (u32)i;
+    }
+
+    // after the scatter offsets[y] is the end of row y
+    u32 begin = 0;
+    for (u32 y = 0; y < height; y++)
+    {
+        ik_cell* row = cells + y * width;
+        for (u32 i = begin; i < offsets[y]; i++)
+        {
+            const compact_pixel* p = pixels + order[i];
+            screen_put(row, p->_x, p->_glyph, p->_foreground, p->_background);
+        }
+        begin = offsets[y];
+    }
+}
+
+void ik_screen_set_pixel(u8 x, u8 y, char to, ik_color foreground, ik_color background){
+    if(x < 0 || x >= SCREEN_WIDTH) return;
+    if(y < 0 || y >= SCREEN_HEIGHT) return;
+
+    screen_put(GET_PIXEL(0, y), x, (u8)to, foreground, background);
+}
+
+u16 ik_glyph_intern(const char* utf8){
+    if (utf8 == 0 || utf8[0] == '\0') return ' ';
+    u32 len = 0;
+    return glyph_intern_next(utf8, &len);
+}
+
+u8 ik_glyph_width(u16 glyph){
+    if (glyph == IK_GLYPH_WIDE_TAIL) return 0;
+    if (!glyph_known(glyph) || glyph < GLYPH_FIRST_ID) return 1;
+    return glyph_at(glyph)->_width;
+}
+
+void ik_screen_set_glyph(u8 x, u8 y, u16 glyph, ik_color foreground, ik_color background){
+    if (x >= SCREEN_WIDTH || y >= SCREEN_HEIGHT) return;
+
+    screen_put(GET_PIXEL(0, y), x, glyph, foreground, background);
+}
+
+u32 ik_screen_set_text(u8 x, u8 y, const char* utf8, ik_color foreground, ik_color background){
+    if (utf8 == 0 || y >= SCREEN_HEIGHT) return 0;
+
+    u32 column = x;
+    ik_cell* row = GET_PIXEL(0, y);
+    while (*utf8 != '\0' && column < SCREEN_WIDTH)
+    {
+        u32 len = 0;
+        u16 glyph = glyph_intern_next(utf8, &len);
+        u8 span = ik_glyph_width(glyph);
+        if (column + span > SCREEN_WIDTH) break;
+
+        screen_put(row, column, glyph, foreground, background);
+        column += span;
+        utf8 += len;
+    }
+    return column - x;
+}
+// frame budget controller, each level adds one measure on top of the previous ones
+#define QUALITY_DIFF_ONLY 1     // only changed cells are written
+#define QUALITY_256_COLORS 2    // colors are capped to the 256-color palette
+#define QUALITY_16_COLORS 3     // colors are capped to the basic colors
+#define QUALITY_SKIP_HALF 4     // every other frame is not presented
+#define QUALITY_SKIP_TWO 5      // two out of three frames are not presented
+#define QUALITY_LEVELS 6
+#define FRAME_HISTORY 16
+
+bool screen_quality_adaptive = true;
+i64 screen_work_us[FRAME_HISTORY] = {};     // time between two ik_screen_print calls
+i64 screen_output_us[FRAME_HISTORY] = {};   // time spent building and writing presented frames
+u32 screen_work_count = 0;
+u32 screen_output_count = 0;
+u32 screen_quality_hold = 0;                // frames until the level may change again
+i64 screen_frame_start = 0;
+i64 screen_deadline = 0;
+bool screen_wait_driven = false;            // ik_wait() paces the frames instead of ik_screen_print()
+u64 screen_tick = 0;
+
+i64 frame_history_average(i64* history, u32 count) {
+    u32 n = (u32)ik_min(count, FRAME_HISTORY);
+    if (n == 0) return 0;
+    i64 sum = 0;
+    for (u32 i = 0; i < n; i++) sum += history[i];
+    return sum / n;
+}
+
+u32 screen_skip_period() {
+    if (screen_stats.quality_level >= QUALITY_SKIP_TWO) return 3;
+    if (screen_stats.quality_level >= QUALITY_SKIP_HALF) return 2;
+    return 1;
+}
+
+//raises the quality level when the frames don't fit the tick and lowers it once they fit twice over
+void screen_adapt_quality() {
+    if (!screen_quality_adaptive || TICKRATE <= 0) return;
+    if (screen_quality_hold > 0)
+    {
+        screen_quality_hold--;
+        return;
+    }
+
+    i64 budget_us = 1000000 / TICKRATE;
+    i64 work = frame_history_average(screen_work_us, screen_work_count);
+    i64 output = frame_history_average(screen_output_us, screen_output_count);
+
+    if (work + output / screen_skip_period() > budget_us && screen_stats.quality_level < QUALITY_LEVELS - 1)
+    {
+        screen_stats.quality_level++;
+        screen_stats.quality_changes++;
+        screen_quality_hold = FRAME_HISTORY / 2;
+    }
+    else if ((work + output) * 2 < budget_us && screen_stats.quality_level > 0)
+    {
+        screen_stats.quality_level--;
+        screen_stats.quality_changes++;
+        screen_quality_hold = FRAME_HISTORY * 2;
+    }
+}
+
+//writes the cells [begin, end) of a row, fore and back carry the colors the terminal currently uses
+void screen_emit_cells(ik_cell* row, u32 begin, u32 end, ik_color_mode mode, ik_color* fore, ik_color* back) {
+    char code[48];
+    for (u32 x = begin; x < end; x++)
+    {
+        ik_cell *_this = row + x;
+        u16 glyph = _this->_glyph;
+        // the terminal already advanced over the tail cell
+        if (glyph == IK_GLYPH_WIDE_TAIL) continue;
+
+        if (_this->_foreground != *fore || _this->_background != *back)
+        {
+            *fore = _this->_foreground;
+            *back = _this->_background;
+            int len = sprintf(code, "\033[");
+            len += color_sgr(code + len, color_downgrade(*fore, mode), false);
+            code[len++] = ';';
+            len += color_sgr(code + len, color_downgrade(*back, mode), true);
+            code[len++] = 'm';
+            screen_write(code, len);
+        }
+        if (glyph < GLYPH_FIRST_ID)
+        {
+            char ch = (char)glyph;
+            screen_write(&ch, 1);
+        }
+        else
+        {
+            screen_glyph* g = glyph_at(glyph);
+            screen_write(g->_utf8, g->_size);
+        }
+    }
+}
+
+bool screen_cell_changed(ik_cell* a, ik_cell* b) {
+    return a->_glyph != b->_glyph || a->_foreground != b->_foreground || a->_background != b->_background;
+}
+
+//builds the frame into screen_output, in diff mode only cells that differ from the front buffer
+void screen_build_frame(bool diff, ik_color_mode mode) {
+    // unchanged gaps shorter than this are rewritten, a cursor jump would cost more
+    const u32 gap_merge = 6;
+    char code[24];
+    ik_color fore = 0xFFFFFFFF, back = 0xFFFFFFFF;
+
+    // hide the cursor while drawing
+    screen_write("\033[?25l", 6);
+    for (u32 y = 0; y < SCREEN_HEIGHT; y++)
+    {
+        ik_cell* row = GET_PIXEL(0, y);
+        if (!diff)
+        {
+            screen_write(code, sprintf(code, "\033[%u;1H", y + 1));
+            screen_emit_cells(row, 0, SCREEN_WIDTH, mode, &fore, &back);
+            continue;
+        }
+
+        ik_cell* front = (ik_cell*)screen_front.data + y * SCREEN_WIDTH;
+        u32 x = 0;
+        while (x < SCREEN_WIDTH)
+        {
+            if (!screen_cell_changed(row + x, front + x))
+            {
+                x++;
+                continue;
+            }
+            // a changed tail means its glyph has to be written again
+            u32 begin = (row[x]._glyph == IK_GLYPH_WIDE_TAIL && x > 0) ? x - 1 : x;
+            u32 end = x + 1, unchanged = 0;
+            while (end < SCREEN_WIDTH && unchanged < gap_merge)
+            {
+                unchanged = screen_cell_changed(row + end, front + end) ? 0 : unchanged + 1;
+                end++;
+            }
+            end -= unchanged;
+
+            screen_write(code, sprintf(code, "\033[%u;%uH", y + 1, begin + 1));
+            screen_emit_cells(row, begin, end, mode, &fore, &back);
+            x = end;
+        }
+    }
+    screen_write("\033[0m\033[?25h", 10);
+}
+
+void ik_screen_print(){
+    i64 now = ik_time_now_us();
+    SCREEN_UPDATE = false;
+    screen_tick++;
+
+    if (screen_frame_start != 0)
+    {
+        screen_work_us[screen_work_count++ % FRAME_HISTORY] = now - screen_frame_start;
+        if (TICKRATE > 0 && now - screen_frame_start > 1000000 / TICKRATE) screen_stats.frames_over_budget++;
+    }
+
+    if (screen_tick % screen_skip_period() != 0)
+    {
+        screen_stats.frames_skipped++;
+    }
+    else
+    {
+        if (!color_tables_ready) color_tables_init();
+        ik_color_mode mode = screen_color_mode;
+        if (screen_stats.quality_level >= QUALITY_16_COLORS) mode = color_mode_16;
+        else if (screen_stats.quality_level >= QUALITY_256_COLORS && mode > color_mode_256) mode = color_mode_256;
+
+#ifndef _WIN32
+        if (screen_fd >= 0 && screen_merge_stale_frame()) screen_stats.frames_merged++;
+#endif
+        bool diff = screen_stats.quality_level >= QUALITY_DIFF_ONLY && screen_front_valid && screen_front_mode == mode;
+        screen_output.size = 0;
+        screen_build_frame(diff, mode);
+        screen_stats.frames_diffed += diff;
+
+        memcpy(screen_front.data, SCREEN_BUFFER.data, SCREEN_BUFFER.size * sizeof(ik_cell));
+        screen_front_valid = true;
+        screen_front_mode = mode;
+
+        i64 write_start = ik_time_now_us();
+        u64 written = screen_output.size;
+        bool congested = false;
+#ifndef _WIN32
+        if (screen_fd >= 0)
+        {
+            // whatever printf buffered goes out before the frame, as it did through stdout
+            fflush(stdout);
+            screen_reserve(&screen_pending, screen_pending.size + screen_output.size);
+            memcpy((byte*)screen_pending.data + screen_pending.size, screen_output.data, screen_output.size);
+            screen_pending.size += screen_output.size;
+            screen_latency_present(now, screen_pending.size);
+            written = screen_flush_pending();
+            congested = screen_output_congested;
+        }
+        else
+#endif
+        {
+            if (!screen_headless)
+            {
+                fwrite(screen_output.data, 1, screen_output.size, stdout);
+                fflush(stdout);
+            }
+            screen_latency_present(now, 0);
+            screen_latency_written(0, ik_time_now_us());
+        }
+        i64 write_end = ik_time_now_us();
+        i64 write_us = write_end - write_start;
+        i64 budget_us = TICKRATE > 0 ? 1000000 / TICKRATE : 1000000 / 60;
+
+        // a congested link costs the frame its whole budget, whatever the write call took
+        screen_output_us[screen_output_count++ % FRAME_HISTORY] = (write_end - now) + congested * budget_us;
+        screen_stats.frames++;
+        screen_stats.frame_bytes = screen_output.size;
+        if (write_us > 0 && !congested)
+        {
+            u64 rate = written * 1000000 / write_us;
+            screen_stats.output_rate = screen_stats.output_rate ? (screen_stats.output_rate * 7 + rate) / 8 : rate;
+        }
+        if (screen_color_adaptive) screen_adapt_color_mode(congested ? budget_us : write_us);
+    }
+    screen_adapt_quality();
+
+    // sleep until the next tick, a late frame moves the schedule instead of sleeping negative time
+    if (TICKRATE > 0)
+    {
+        now = ik_time_now_us();
+        screen_deadline += 1000000 / TICKRATE;
+        if (screen_deadline < now || screen_headless) screen_deadline = now;
+    }
+    if (TICKRATE > 0 && !screen_wait_driven && !screen_headless)
+    {
+#ifndef _WIN32
+        if (screen_fd >= 0) screen_flush_until(screen_deadline);
+        now = ik_time_now_us();
+#endif
+        ik_sleep((screen_deadline - now) / 1000);
+    }
+#ifndef _WIN32
+    else if (screen_fd >= 0) screen_flush_pending();
+    screen_stats.pending_bytes = screen_pending.size - screen_pending_sent;
+#endif
+    screen_frame_start = ik_time_now_us();
+    SCREEN_UPDATE = TICKRATE <= 0 || !screen_wait_driven || screen_headless;
+}
+
+void ik_screen_set_headless(bool enabled){
+    screen_headless = enabled;
+}
+void ik_screen_set_adaptive_quality(bool enabled){
+    screen_quality_adaptive = enabled;
+    if (!enabled) screen_stats.quality_level = 0;
+}
+void ik_screen_set_color_mode(ik_color_mode mode, bool adaptive){
+    SCREEN_COLOR_MODE = mode;
+    screen_color_mode = mode;
+    screen_color_adaptive = adaptive;
+    screen_link_strained = 0;
+    screen_link_calm = 0;
+}
+
+ik_color_mode ik_screen_get_color_mode(){
+    return screen_color_mode;
+}
+
+bool ik_screen_output_congested(){
+#ifndef _WIN32
+    return screen_output_congested;
+#else
+    return false;
+#endif
+}
+
+i64 ik_screen_latency_percentile(ik_latency_stage stage, double percentile){
+    if ((u32)stage >= LATENCY_STAGES || latency_samples[stage] == 0) return 0;
+    u64 rank = (u64)(percentile / 100.0 * latency_samples[stage]);
+    if (rank >= latency_samples[stage]) rank = latency_samples[stage] - 1;
+
+    u64 seen = 0;
+    for (u32 i = 0; i < LATENCY_BUCKETS; i++)
+    {
+        seen += latency_histogram[stage][i];
+        if (seen > rank) return ik_min(latency_bucket_limit(i), latency_max[stage]);
+    }
+    return latency_max[stage];
+}
+
+void ik_screen_get_latency(ik_latency_stage stage, ik_latency_stats* out){
+    memset(out, 0, sizeof(ik_latency_stats));
+    if ((u32)stage >= LATENCY_STAGES || latency_samples[stage] == 0) return;
+    out->samples = latency_samples[stage];
+    out->min_us = latency_min[stage];
+    out->max_us = latency_max[stage];
+    out->mean_us = latency_sum[stage] / (i64)latency_samples[stage];
+    out->p50_us = ik_screen_latency_percentile(stage, 50);
+    out->p90_us = ik_screen_latency_percentile(stage, 90);
+    out->p99_us = ik_screen_latency_percentile(stage, 99);
+    out->p999_us = ik_screen_latency_percentile(stage, 99.9);
+}
+
+void ik_screen_reset_latency(){
+    memset(latency_histogram, 0, sizeof(latency_histogram));
+    memset(latency_samples, 0, sizeof(latency_samples));
+    memset(latency_sum, 0, sizeof(latency_sum));
+    memset(latency_max, 0, sizeof(latency_max));
+}
+
+void ik_screen_get_stats(ik_screen_stats* out){
+    if (out == 0) return;
+    *out = screen_stats;
+}
+
+void ik_screen_clear_screen(){
+    ik_cell* cells = (ik_cell*)SCREEN_BUFFER.data;
+    ik_cell blank = { (u8)SCREEN_BACKGROUND, none, none };
+    for (size_t i = 0; i < SCREEN_BUFFER.size; i++)
+    {
+        cells[i] = blank;
+    }
+}
+
+
+#pragma endregion
+
+#pragma region Sleep
+
+void ik_sleep(i64 milliseconds)
+{
+    if (milliseconds < 0) return;
+#ifdef _WIN32
+	Sleep(milliseconds);
+#else
+	usleep(milliseconds * 1000);
+#endif
+}
+
+i64 ik_time_now_us()
+{
+#ifdef _WIN32
+    static LARGE_INTEGER frequency = { };
+    if (frequency.QuadPart == 0) QueryPerformanceFrequency(&frequency);
+    LARGE_INTEGER now;
+    QueryPerformanceCounter(&now);
+    return (i64)(now.QuadPart / frequency.QuadPart * 1000000 + now.QuadPart % frequency.QuadPart * 1000000 / frequency.QuadPart);
+#else
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (i64)now.tv_sec * 1000000 + now.tv_nsec / 1000;
+#endif
+}
+
+#pragma endregion
+
+#pragma region Input
+
+#define INPUT_QUEUE_SIZE 256
+
+ik_input_type INPUT_TYPE = stream;
+#define INPUT_WORDS (256 / 64)
+
+// one bit per key code, key >> 6 picks the word and key & 63 the bit
+u64 input_down[INPUT_WORDS] = {};               // keys that are down after the events so far
+u64 input_went_down[INPUT_WORDS] = {};          // keys with a key_down event during this update
+u64 input_went_up[INPUT_WORDS] = {};            // keys with a key_up event during this update
+u64 input_release_pending[INPUT_WORDS] = {};    // keys pressed and released within one update, reported released in the next
+u64 input_states[3][INPUT_WORDS] = {};          // the polled view, indexed by ik_key_state
+
+bool input_bit(const u64* bits, u8 key) {
+    return (bits[key >> 6] >> (key & 63)) & 1;
+}
+
+ik_input_event input_queue[INPUT_QUEUE_SIZE];
+u32 input_queue_head = 0;
+u32 input_queue_tail = 0;
+u32 input_update_end = 0;           // the queue head when the last update ended
+u8 input_mouse_x = 0;
+u8 input_mouse_y = 0;
+
+
+//records an event for ik_poll_input_event() and applies it to the polled key states
+void input_push_event(u8 key, u8 type, u32 ch, i64 time, u8 x, u8 y) {
+    u64 bit = 1ull << (key & 63);
+    if (key != 0 && type == key_down)
+    {
+        input_went_down[key >> 6] |= bit;
+        input_down[key >> 6] |= bit;
+    }
+    else if (key != 0 && type == key_up)
+    {
+        input_went_up[key >> 6] |= bit;
+        input_down[key >> 6] &= ~bit;
+    }
+
+    input_mouse_x = x;
+    input_mouse_y = y;
+
+    // a move right after a move of the same update replaces it, if nobody has taken it yet
+    ik_input_event* last = input_queue + ((input_queue_head - 1) & (INPUT_QUEUE_SIZE - 1));
+    bool merge = type == mouse_move && input_queue_head != input_queue_tail &&
+                 input_queue_head != input_update_end && last->_type == mouse_move;
+
+    // a full queue drops its oldest event, the key states above have seen it anyway
+    if (!merge && input_queue_head - input_queue_tail == INPUT_QUEUE_SIZE) input_queue_tail++;
+    ik_input_event* e = merge ? last : input_queue + (input_queue_head++ & (INPUT_QUEUE_SIZE - 1));
+    e->_time_us = time;
+    e->_char = ch;
+    e->_key = key;
+    e->_type = type;
+    e->_x = x;
+    e->_y = y;
+}
+
+// a recording is the magic, a version byte and the seed, followed by one entry per update that
+// had events or a state hash: the update distance, count << 2 | end << 1 | has hash, the hash
+// and the events as key, type, mouse x and y, char and the time distance to the previous event.
+// Numbers are LEB128, the time distance zigzag coded. The end entry carries the last update.
+#define INPUT_RECORD_MAGIC "IKIR"
+#define INPUT_RECORD_VERSION 2
+#define INPUT_RECORD_END 2
+#define INPUT_RECORD_HASH 1
+
+FILE* input_record_file = 0;
+FILE* input_replay_file = 0;
+u64 input_tick = 0;                 // updates since the recording or replay started
+u64 input_file_tick = 0;            // the update of the last entry written or read
+i64 input_file_start = 0;           // ik_time_now_us() when the recording or replay started
+i64 input_file_time = 0;            // the time of the last event written or read, relative to the start
+u32 input_record_from = 0;          // first queue event the next entry records, it ends at input_update_end
+bool input_sync_set = false;        // recording: a hash was given this update. replay: the entry has one
+u32 input_sync_hash = 0;
+bool input_replay_over = false;
+u64 input_replay_tick = 0;          // the update of the entry read ahead
+u32 input_replay_count = 0;         // its events, still in the file
+u8 input_replay_flags = 0;
+u32 input_replay_hash = 0;
+
+void input_file_put(u64 value) {
+    do
+    {
+        u8 b = value & 0x7F;
+        value >>= 7;
+        fputc(b | (value ? 0x80 : 0), input_record_file);
+    } while (value);
+}
+
+bool input_file_get(u64* value) {
+    *value = 0;
+    for (u32 shift = 0; shift < 64; shift += 7)
+    {
+        int c = fgetc(input_replay_file);
+        if (c == EOF) return false;
+        *value |= (u64)(c & 0x7F) << shift;
+        if (!(c & 0x80)) return true;
+    }
+    return false;
+}
+
+//writes the entry of the last update, if it had anything to record. It is flushed right away, a
+//signal that ends the process leaves no stdio buffer behind and the file is complete up to here.
+void input_record_flush(u8 end) {
+    u32 count = input_update_end - input_record_from;
+    if (count > INPUT_QUEUE_SIZE) count = INPUT_QUEUE_SIZE;
+    if (count == 0 && !input_sync_set && !end) return;
+
+    input_file_put(input_tick - input_file_tick);
+    input_file_put((u64)count << 2 | end | (input_sync_set ? INPUT_RECORD_HASH : 0));
+    if (input_sync_set) input_file_put(input_sync_hash);
+    for (u32 i = input_update_end - count; i != input_update_end; i++)
+    {
+        ik_input_event* e = input_queue + (i & (INPUT_QUEUE_SIZE - 1));
+        i64 time = e->_time_us - input_file_start;
+        i64 delta = time - input_file_time;
+        fputc(e->_key, input_record_file);
+        fputc(e->_type, input_record_file);
+        fputc(e->_x, input_record_file);
+        fputc(e->_y, input_record_file);
+        input_file_put(e->_char);
+        input_file_put((u64)((delta << 1) ^ (delta >> 63)));
+        input_file_time = time;
+    }
+    input_file_tick = input_tick;
+    input_record_from = input_update_end;
+    input_sync_set = false;
+    fflush(input_record_file);
+}
+
+//reads the head of the next entry, its events are read when its update comes
+void input_replay_read_ahead() {
+    u64 distance, header, hash = 0;
+    if (!input_file_get(&distance) || !input_file_get(&header)
+        || ((header & INPUT_RECORD_HASH) && !input_file_get(&hash)))
+    {
+        // a cut off recording ends where it can be read, the tick it would have named is unknown
+        input_replay_flags = INPUT_RECORD_END;
+        input_replay_tick = input_file_tick;
+        input_replay_count = 0;
+        input_replay_over = true;
+        return;
+    }
+    input_replay_tick = input_file_tick + distance;
+    input_replay_count = (u32)(header >> 2);
+    input_replay_flags = (u8)(header & 3);
+    input_replay_hash = (u32)hash;
+}
+
+//pushes the recorded events of this update
+void input_replay_update() {
+    input_tick++;
+    input_sync_set = false;
+    if (input_replay_over || input_tick != input_replay_tick) return;
+
+    for (u32 i = 0; i < input_replay_count; i++)
+    {
+        u8 head[4];
+        u64 ch, zigzag;
+        if (fread(head, 1, 4, input_replay_file) != 4 || !input_file_get(&ch) || !input_file_get(&zigzag)) break;
+        input_file_time += (i64)(zigzag >> 1) ^ -(i64)(zigzag & 1);
+        input_push_event(head[0], head[1], (u32)ch, input_file_start + input_file_time, head[2], head[3]);
+    }
+    input_sync_set = input_replay_flags & INPUT_RECORD_HASH;
+    input_sync_hash = input_replay_hash;
+    input_file_tick = input_tick;
+    if (input_replay_flags & INPUT_RECORD_END) input_replay_over = true;
+    else input_replay_read_ahead();
+}
+
+#ifdef _WIN32
+// the keys polled every update, the mouse buttons and the OEM range are left out
+bool input_polled_key(u32 key) {
+    return key == IK_KEY_BACKSPACE || key == IK_KEY_TAB || key == IK_KEY_ENTER ||
+           (key >= IK_KEY_SHIFT && key <= IK_KEY_ALT) || key == IK_KEY_ESCAPE ||
+           (key >= IK_KEY_SPACE && key <= IK_KEY_DOWN) || key == IK_KEY_INSERT || key == IK_KEY_DELETE ||
+           (key >= '0' && key <= '9') || (key >= 'A' && key <= 'Z') || (key >= IK_KEY_F1 && key <= IK_KEY_F12);
+}
+
+//the character a key types, only letters, digits and space are known without a message loop
+u32 input_key_char(u32 key) {
+    if (key >= 'A' && key <= 'Z') return input_bit(input_down, IK_KEY_SHIFT) ? key : key + 32;
+    if ((key >= '0' && key <= '9') || key == IK_KEY_SPACE) return key;
+    return 0;
+}
+#else
+// the terminal only reports presses and repeats. A key stays down for the repeat delay after a
+// press and for a bit more than the repeat interval once it repeats.
+#define INPUT_HOLD_US 550000
+#define INPUT_REPEAT_US 120000
+#define INPUT_RING_SIZE 4096
+#define INPUT_ESCAPE_US 30000           // how long the input thread waits for the rest of an escape sequence
+#define INPUT_MOVE_RETRY_US 2000        // how often the input thread offers a held back mouse move or missed keys again
+#define INPUT_THREAD_QUEUE_SIZE 1024
+
+struct termios input_saved_termios;
+bool input_raw = false;
+u8 input_ring[INPUT_RING_SIZE];
+u32 input_ring_head = 0;        // next byte to write
+u32 input_ring_tail = 0;        // next byte to decode
+u32 input_stale_bytes = 0;      // undecodable bytes left over from the last update
+i64 input_last_read = 0;        // when the last bytes came in
+i64 input_last_seen[256] = {};
+bool input_repeating[256] = {};
+u64 input_term_down[INPUT_WORDS] = {};  // the keys the decoder considers down, it may run on the input thread
+u8 input_term_mouse_x = 0;              // the mouse cell of the last report the decoder saw
+u8 input_term_mouse_y = 0;
+bool input_mouse = false;
+
+// the input thread is the only writer of the head and the game thread the only writer of the tail
+bool input_thread_running = false;
+bool input_terminal_closed = false;
+pthread_t input_thread;
+int input_thread_stop[2] = { -1, -1 };
+int input_thread_wake[2] = { -1, -1 };  // readable while the thread has queued events, ik_wait() polls it
+ik_input_event input_thread_queue[INPUT_THREAD_QUEUE_SIZE];
+std::atomic<u32> input_thread_head{ 0 };
+std::atomic<u32> input_thread_tail{ 0 };
+ik_input_event input_thread_move = { };     // the newest move, held back while the game has not taken the last one
+bool input_thread_move_held = false;
+bool input_thread_move_sent = false;
+u32 input_thread_move_index = 0;            // queue index of the last move sent
+u64 input_thread_sent_down[INPUT_WORDS] = {};   // the key states the game ends up with from the published events
+u64 input_thread_missed[INPUT_WORDS] = {};      // keys with transitions a full queue could not take
+bool input_thread_overflow = false;
+
+u32 input_thread_room() {
+    return INPUT_THREAD_QUEUE_SIZE - (input_thread_head.load(std::memory_order_relaxed) - input_thread_tail.load(std::memory_order_acquire));
+}
+
+bool input_thread_publish(const ik_input_event* event) {
+    if (input_thread_room() == 0) return false;
+    u32 head = input_thread_head.load(std::memory_order_relaxed);
+    u64 bit = 1ull << (event->_key & 63);
+    if (event->_type == mouse_move)
+    {
+        input_thread_move_sent = true;
+        input_thread_move_index = head;
+    }
+    else if (event->_key != 0 && event->_type == key_down) input_thread_sent_down[event->_key >> 6] |= bit;
+    else if (event->_key != 0 && event->_type == key_up) input_thread_sent_down[event->_key >> 6] &= ~bit;
+    input_thread_queue[head & (INPUT_THREAD_QUEUE_SIZE - 1)] = *event;
+    input_thread_head.store(head + 1, std::memory_order_release);
+    return true;
+}
+
+//sends the held back move, always or only once the game took the last one. It stays held while the queue is full.
+void input_thread_flush_move(bool always) {
+    if (!input_thread_move_held) return;
+    u32 tail = input_thread_tail.load(std::memory_order_acquire);
+    if (!always && input_thread_move_sent && (i32)(input_thread_move_index - tail) >= 0) return;
+    if (input_thread_publish(&input_thread_move)) input_thread_move_held = false;
+}
+
+//publishes what a full queue missed once there is room. A key goes from the state the game has to
+//the state the decoder has, a key that ended where it started gets both transitions.
+void input_thread_flush_missed() {
+    if (!input_thread_overflow) return;
+    ik_input_event event = { ik_time_now_us(), 0, 0, 0, input_term_mouse_x, input_term_mouse_y };
+    for (u32 w = 0; w < INPUT_WORDS; w++)
+    {
+        while (input_thread_missed[w])
+        {
+            u32 bit = math_lowest_bit64(input_thread_missed[w]);
+            event._key = (u8)(w * 64 + bit);
+            bool down = input_bit(input_term_down, event._key);
+            bool both = down == input_bit(input_thread_sent_down, event._key);
+            if (input_thread_room() < (both ? 2u : 1u)) return;
+
+            if (both)
+            {
+                event._type = down ? key_up : key_down;
+                input_thread_publish(&event);
+            }
+            event._type = down ? key_down : key_up;
+            input_thread_publish(&event);
+            input_thread_missed[w] &= ~(1ull << bit);
+        }
+    }
+    input_thread_overflow = false;
+}
+
+//hands a decoded event to the game thread, straight or through the input thread queue
+void input_emit(u8 key, u8 type, u32 ch, i64 time) {
+    if (!input_thread_running)
+    {
+        input_push_event(key, type, ch, time, input_term_mouse_x, input_term_mouse_y);
+        return;
+    }
+    input_thread_flush_missed();
+
+    ik_input_event event = { time, ch, key, type, input_term_mouse_x, input_term_mouse_y };
+    if (type == mouse_move)
+    {
+        // a drag must not fill the queue, only the newest move waits for the game
+        input_thread_move = event;
+        input_thread_move_held = true;
+        input_thread_flush_move(false);
+        return;
+    }
+    input_thread_flush_move(true);
+
+    // a full queue drops repeats and characters without a key, a key that missed a transition
+    // takes the later ones with it when there is room again
+    bool transition = key != 0 && (type == key_down || type == key_up);
+    if (transition && input_bit(input_thread_missed, key)) return;
+    if (input_thread_publish(&event) || !transition) return;
+    input_thread_missed[key >> 6] |= 1ull << (key & 63);
+    input_thread_overflow = true;
+}
+
+//applies everything the input thread queued since the last update
+void input_thread_drain() {
+    u32 tail = input_thread_tail.load(std::memory_order_relaxed);
+    u32 head = input_thread_head.load(std::memory_order_acquire);
+    for (; tail != head; tail++)
+    {
+        ik_input_event* e = input_thread_queue + (tail & (INPUT_THREAD_QUEUE_SIZE - 1));
+        input_push_event(e->_key, e->_type, e->_char, e->_time_us, e->_x, e->_y);
+    }
+    input_thread_tail.store(tail, std::memory_order_release);
+}
+
+void input_mouse_report(bool enabled) {
+    const char* sequence = enabled ? "\033[?1003h\033[?1006h" : "\033[?1003l\033[?1006l";
+    while (write(STDOUT_FILENO, sequence, strlen(sequence)) < 0 && errno == EINTR) {}
+}
+
+void input_restore_terminal() {
+    if (!input_raw) return;
+    if (input_mouse) input_mouse_report(false);
+    input_mouse = false;
+    tcsetattr(STDIN_FILENO, TCSANOW, &input_saved_termios);
+    input_raw = false;
+}
+
+int input_signals[] = { SIGINT, SIGTERM, SIGHUP, SIGQUIT, SIGABRT, SIGSEGV };
+struct sigaction input_previous_actions[sizeof(input_signals) / sizeof(input_signals[0])];
+
+//a handler installed before ours decides itself what happens, if it exits atexit restores the
+//terminal. Otherwise the terminal is restored before the default action ends the process.
+void input_signal_handler(int sig, siginfo_t* info, void* context) {
+    for (size_t i = 0; i < sizeof(input_signals) / sizeof(input_signals[0]); i++)
+    {
+        if (input_signals[i] != sig) continue;
+        struct sigaction* previous = input_previous_actions + i;
+        if (previous->sa_flags & SA_SIGINFO)
+        {
+            previous->sa_sigaction(sig, info, context);
+            return;
+        }
+        if (previous->sa_handler != SIG_DFL && previous->sa_handler != SIG_IGN)
+        {
+            previous->sa_handler(sig);
+            return;
+        }
+        break;
+    }
+    input_restore_terminal();
+
+    struct sigaction fallback = { };
+    fallback.sa_handler = SIG_DFL;
+    sigaction(sig, &fallback, 0);
+    raise(sig);
+}
+
+void input_enter_raw() {
+    if (input_raw || !isatty(STDIN_FILENO)) return;
+    if (tcgetattr(STDIN_FILENO, &input_saved_termios) != 0) return;
+
+    // cbreak without echo, VMIN/VTIME 0 make read() return at once instead of setting
+    // O_NONBLOCK, which stdout would share
+    struct termios raw = input_saved_termios;
+    raw.c_lflag &= ~(ICANON | ECHO);
+    raw.c_cc[VMIN] = 0;
+    raw.c_cc[VTIME] = 0;
+    if (tcsetattr(STDIN_FILENO, TCSANOW, &raw) != 0) return;
+    input_raw = true;
+
+    static bool handlers_installed = false;
+    if (handlers_installed) return;
+    handlers_installed = true;
+    atexit(input_restore_terminal);
+
+    struct sigaction action = { };
+    action.sa_sigaction = input_signal_handler;
+    action.sa_flags = SA_SIGINFO | SA_RESTART;
+    sigemptyset(&action.sa_mask);
+    for (size_t i = 0; i < sizeof(input_signals) / sizeof(input_signals[0]); i++)
+    {
+        // an ignored signal stays ignored, it can not end the process in raw mode
+        if (sigaction(input_signals[i], 0, input_previous_actions + i) != 0) continue;
+        if (!(input_previous_actions[i].sa_flags & SA_SIGINFO) && input_previous_actions[i].sa_handler == SIG_IGN) continue;
+        sigaction(input_signals[i], &action, 0);
+    }
+}
+
+u8 input_ring_at(u32 i) {
+    return input_ring[(input_ring_tail + i) & (INPUT_RING_SIZE - 1)];
+}
+
+void input_key_seen(u8 key, u8 modifier, u32 ch, i64 now) {
+    if (modifier) input_key_seen(modifier, 0, 0, now);
+
+    bool down = key != 0 && input_bit(input_term_down, key);
+    if (key != 0) input_term_down[key >> 6] |= 1ull << (key & 63);
+    input_repeating[key] = down;
+    input_last_seen[key] = now;
+    input_emit(key, down ? key_repeat : key_down, ch, now);
+}
+
+//maps the final byte of a CSI or SS3 sequence to a key
+u8 input_decode_final(u8 final, i32 param) {
+    switch (final)
+    {
+        case 'A': return IK_KEY_UP;
+        case 'B': return IK_KEY_DOWN;
+        case 'C': return IK_KEY_RIGHT;
+        case 'D': return IK_KEY_LEFT;
+        case 'H': return IK_KEY_HOME;
+        case 'F': return IK_KEY_END;
+        case 'P': return IK_KEY_F1;
+        case 'Q': return IK_KEY_F1 + 1;
+        case 'R': return IK_KEY_F1 + 2;
+        case 'S': return IK_KEY_F1 + 3;
+        case '~': break;
+        default: return 0;
+    }
+    // vt220 style keys, ESC [ param ~
+    static const u8 tilde[25] = {
+        0, IK_KEY_HOME, IK_KEY_INSERT, IK_KEY_DELETE, IK_KEY_END, IK_KEY_PAGE_UP, IK_KEY_PAGE_DOWN, IK_KEY_HOME, IK_KEY_END, 0,
+        0, IK_KEY_F1, IK_KEY_F1 + 1, IK_KEY_F1 + 2, IK_KEY_F1 + 3, IK_KEY_F1 + 4, 0, IK_KEY_F1 + 5, IK_KEY_F1 + 6, IK_KEY_F1 + 7,
+        IK_KEY_F1 + 8, IK_KEY_F1 + 9, 0, IK_KEY_F1 + 10, IK_KEY_F1 + 11,
+    };
+    return (param > 0 && param < 25) ? tilde[param] : 0;
+}
+
+//decodes an SGR mouse report, ESC [ < button ; column ; row M on press and m on release
+u32 input_decode_mouse(u32 at, u32 available, i64 now) {
+    i32 params[3] = { 0, 0, 0 };
+    u32 count = 0;
+    for (u32 i = 3; i < available; i++)
+    {
+        u8 b = input_ring_at(at + i);
+        if (b >= '0' && b <= '9')
+        {
+            if (count < 3) params[count] = params[count] * 10 + (b - '0');
+            continue;
+        }
+        if (b == ';')
+        {
+            count++;
+            continue;
+        }
+        if (b != 'M' && b != 'm') return i + 1;
+
+        // frames are drawn from the top left corner, so terminal cells are screen cells plus one
+        input_term_mouse_x = (u8)ik_min(ik_max(params[1] - 1, 0), 255);
+        input_term_mouse_y = (u8)ik_min(ik_max(params[2] - 1, 0), 255);
+
+        // the low bits are the button, 32 marks a move and 64 the wheel, the rest are modifiers
+        i32 button = params[0];
+        if (button & 64) input_emit(button & 1 ? IK_KEY_DOWN : IK_KEY_UP, mouse_scroll, 0, now);
+        else if (button & 32) input_emit(0, mouse_move, 0, now);
+        else
+        {
+            static const u8 buttons[4] = { IK_KEY_MOUSE_LEFT, IK_KEY_MOUSE_MIDDLE, IK_KEY_MOUSE_RIGHT, 0 };
+            u8 key = buttons[button & 3];
+            if (key != 0) input_emit(key, b == 'M' ? key_down : key_up, 0, now);
+        }
+        return i + 1;
+    }
+    return 0;
+}
+
+//decodes the key at offset at, returns the bytes it used or 0 if the sequence is incomplete
+u32 input_decode_key(u32 at, u32 available, i64 now) {
+    u8 c = input_ring_at(at);
+
+    if (c == 0x1B)
+    {
+        if (available == 1) return 0;
+        u8 kind = input_ring_at(at + 1);
+        if (kind != '[' && kind != 'O')
+        {
+            // alt + key arrives as ESC followed by the key
+            u32 used = input_decode_key(at + 1, available - 1, now);
+            if (used == 0) return 0;
+            input_key_seen(IK_KEY_ALT, 0, 0, now);
+            return used + 1;
+        }
+
+        if (kind == '[' && available > 2 && input_ring_at(at + 2) == '<') return input_decode_mouse(at, available, now);
+
+        // ESC [ params final or ESC O final, the second parameter carries the modifiers
+        i32 params[2] = { 0, 0 };
+        u32 count = 0;
+        for (u32 i = 2; i < available; i++)
+        {
+            u8 b = input_ring_at(at + i);
+            if (b >= '0' && b <= '9')
+            {
+                if (count < 2) params[count] = params[count] * 10 + (b - '0');
+                continue;
+            }
+            if (b == ';')
+            {
+                count++;
+                continue;
+            }
+            u8 key = input_decode_final(b, params[0]);
+            if (key == 0) return i + 1;
+
+            u8 modifier = 0;
+            i32 mods = params[1] - 1;
+            if (mods > 0 && (mods & 1)) modifier = IK_KEY_SHIFT;
+            if (mods > 0 && (mods & 2)) input_key_seen(IK_KEY_ALT, 0, 0, now);
+            if (mods > 0 && (mods & 4)) input_key_seen(IK_KEY_CONTROL, 0, 0, now);
+            input_key_seen(key, modifier, 0, now);
+            return i + 1;
+        }
+        return 0;
+    }
+
+    if (c >= 'a' && c <= 'z') input_key_seen(c - 32, 0, c, now);
+    else if (c >= 'A' && c <= 'Z') input_key_seen(c, IK_KEY_SHIFT, c, now);
+    else if (c >= '0' && c <= '9') input_key_seen(c, 0, c, now);
+    else if (c == ' ') input_key_seen(IK_KEY_SPACE, 0, c, now);
+    else if (c == '\r' || c == '\n') input_key_seen(IK_KEY_ENTER, 0, 0, now);
+    else if (c == '\t') input_key_seen(IK_KEY_TAB, 0, 0, now);
+    else if (c == 0x7F || c == 0x08) input_key_seen(IK_KEY_BACKSPACE, 0, 0, now);
+    else if (c >= 0x01 && c <= 0x1A) input_key_seen(c + 64, IK_KEY_CONTROL, 0, now);
+    else if (c >= 0x80)
+    {
+        // other text only arrives as characters, there is no key for it
+        u32 len = 0;
+        u8 bytes[5] = { };
+        u32 need = c >= 0xF0 ? 4 : c >= 0xE0 ? 3 : 2;
+        if (available < need) return 0;
+        for (u32 i = 0; i < need; i++) bytes[i] = input_ring_at(at + i);
+        u32 cp = utf8_decode((const char*)bytes, &len);
+        input_key_seen(0, 0, cp, now);
+        return len;
+    }
+    else if (c >= 0x20 && c < 0x7F) input_key_seen(0, 0, c, now);
+    return 1;
+}
+
+//one read for everything the terminal buffered, then decode it
+void input_read_terminal(i64 now) {
+    u32 free = INPUT_RING_SIZE - (input_ring_head - input_ring_tail);
+    u32 head = input_ring_head & (INPUT_RING_SIZE - 1);
+    u32 contiguous = (u32)ik_min(free, INPUT_RING_SIZE - head);
+    ssize_t n = contiguous > 0 ? read(STDIN_FILENO, input_ring + head, contiguous) : 0;
+    if (n > 0)
+    {
+        input_ring_head += (u32)n;
+        input_last_read = now;
+    }
+
+    u32 available = input_ring_head - input_ring_tail;
+    while (available > 0)
+    {
+        u32 used = input_decode_key(0, available, now);
+        if (used == 0)
+        {
+            // an incomplete sequence that did not grow since the last update is a lone escape
+            if (n > 0 || input_stale_bytes != available) break;
+            input_key_seen(IK_KEY_ESCAPE, 0, 0, now);
+            used = 1;
+        }
+        input_ring_tail += used;
+        available -= used;
+    }
+    input_stale_bytes = available;
+}
+
+//releases the keys whose repeats stopped, returns when the next held key runs out or -1 if none is held
+i64 input_release_expired(i64 now) {
+    i64 next = -1;
+    for (u32 w = 0; w < INPUT_WORDS; w++)
+    {
+        u64 down = input_term_down[w];
+        while (down != 0)
+        {
+            u8 key = (u8)(w * 64 + math_lowest_bit64(down));
+            down &= down - 1;
+
+            i64 expires = input_last_seen[key] + (input_repeating[key] ? INPUT_REPEAT_US : INPUT_HOLD_US);
+            if (now >= expires)
+            {
+                input_term_down[w] &= ~(1ull << (key & 63));
+                input_emit(key, key_up, 0, expires);
+            }
+            else if (next < 0 || expires < next) next = expires;
+        }
+    }
+    return next;
 }
 
-#pragma endregion
+void* input_thread_main(void*) {
+    // terminating signals are handled by the game thread
+    sigset_t all;
+    sigfillset(&all);
+    pthread_sigmask(SIG_BLOCK, &all, 0);
 
-#pragma region Comparator
+    int input_fd = STDIN_FILENO;
+    u32 notified = input_thread_head.load(std::memory_order_relaxed);
+    while (true)
+    {
+        i64 now = ik_time_now_us();
+        i64 next = input_release_expired(now);
+        if (input_ring_head != input_ring_tail && (next < 0 || input_last_read + INPUT_ESCAPE_US < next))
+            next = input_last_read + INPUT_ESCAPE_US;
+        input_thread_flush_missed();
+        input_thread_flush_move(false);
+        if ((input_thread_move_held || input_thread_overflow) && (next < 0 || now + INPUT_MOVE_RETRY_US < next))
+            next = now + INPUT_MOVE_RETRY_US;
+        int timeout = next < 0 ? -1 : (int)ik_max((next - now + 999) / 1000, 0);
+
+        // tell ik_wait() about everything queued since the last time before blocking again
+        u32 queued = input_thread_head.load(std::memory_order_relaxed);
+        if (queued != notified)
+        {
+            u8 wake = 1;
+            write(input_thread_wake[1], &wake, 1);
+            notified = queued;
+        }
 
-bool ik_compare_string(void* a, void* b)
-{
-    u64 upper_limit = ik_min(((ik_string*)a)->size, ((ik_string*)b)->size);
-    ik_string _a;
-    ik_string _b;
+        struct pollfd fds[2] = { { input_fd, POLLIN, 0 }, { input_thread_stop[0], POLLIN, 0 } };
+        if (poll(fds, 2, timeout) < 0 && errno != EINTR) break;
+        if (fds[1].revents != 0) break;
 
-    memset(&_a, '\0', sizeof(ik_string));
-    memset(&_b, '\0', sizeof(ik_string));
+        input_read_terminal(ik_time_now_us());
+        // a closed terminal keeps polling readable, stop watching it
+        if (fds[0].revents & (POLLHUP | POLLERR | POLLNVAL)) input_fd = -1;
+    }
+    return 0;
+}
 
-    ik_string_make(&_a, ((ik_string*)a)->cstring);
-    ik_string_make(&_b, ((ik_string*)b)->cstring);
+void input_thread_close_pipes() {
+    int* pipes[] = { input_thread_stop, input_thread_wake };
+    for (u32 i = 0; i < 2; i++)
+    {
+        if (pipes[i][0] >= 0) close(pipes[i][0]);
+        if (pipes[i][1] >= 0) close(pipes[i][1]);
+        pipes[i][0] = pipes[i][1] = -1;
+    }
+}
 
-    ik_to_lower(_a.cstring);
-    ik_to_lower(_b.cstring);
+void input_thread_join() {
+    if (!input_thread_running) return;
+    u8 stop = 1;
+    while (write(input_thread_stop[1], &stop, 1) < 0 && errno == EINTR) {}
+    pthread_join(input_thread, 0);
+    input_thread_close_pipes();
+    input_thread_running = false;
+
+    // whatever the thread queued or missed last still reaches the next update
+    input_thread_drain();
+    input_thread_flush_missed();
+    input_thread_drain();
+}
+#endif
 
-    for (int i = 0; i < upper_limit; i++)
+void ik_init_input() {
+    memset(input_down, 0, sizeof(input_down));
+    memset(input_went_down, 0, sizeof(input_went_down));
+    memset(input_went_up, 0, sizeof(input_went_up));
+    memset(input_release_pending, 0, sizeof(input_release_pending));
+    memset(input_states, 0, sizeof(input_states));
+#ifndef _WIN32
+    memset(input_term_down, 0, sizeof(input_term_down));
+#endif
+}
+void ik_set_input_type(ik_input_type type) {
+    INPUT_TYPE = type;
+#ifndef _WIN32
+    if (type == keyboardhit) input_enter_raw();
+    else
     {
-        if (_a.cstring[i] == _b.cstring[i])
+        input_thread_join();
+        input_restore_terminal();
+    }
+#endif
+}
+
+void ik_update_input() {
+    if (INPUT_TYPE != keyboardhit && !input_replay_file) return;
+    i64 now = ik_time_now_us();
+
+    if (input_replay_file) input_replay_update();
+    else
+    {
+        if (input_record_file)
         {
-            continue;
+            input_record_flush(0);
+            input_tick++;
         }
+#ifdef _WIN32
+        for (u32 key = 0; key < 256; key++)
+        {
+            if (!input_polled_key(key)) continue;
+            bool down = (GetAsyncKeyState(key) & 0x8000) != 0;
+            if (down != input_bit(input_down, key))
+                input_push_event(key, down ? key_down : key_up, down ? input_key_char(key) : 0, now, input_mouse_x, input_mouse_y);
+        }
+#else
+        if (input_thread_running) input_thread_drain();
+        else
+        {
+            // without raw mode stdin is no terminal, a pipe or socket there would block the read
+            if (input_raw) input_read_terminal(now);
+            input_release_expired(now);
+        }
+#endif
+    }
+    // the first frame presented after this update shows its events, a replay has no real arrival times
+    u32 first = input_queue_head - input_update_end > INPUT_QUEUE_SIZE ? input_queue_head - INPUT_QUEUE_SIZE : input_update_end;
+    for (u32 i = first; i != input_queue_head && !input_replay_file; i++)
+    {
+        screen_latency_stamp(input_queue[i & (INPUT_QUEUE_SIZE - 1)]._time_us, now);
+    }
 
-        bool ret = _a.cstring[i] > _b.cstring[i];
-        ik_string_destroy(&_a);
-        ik_string_destroy(&_b);
+    // events that come in before the next update belong to that one
+    input_update_end = input_queue_head;
 
-        return ret;
+    // the polled view is whatever the events of this update did to each key
+    for (u32 w = 0; w < INPUT_WORDS; w++)
+    {
+        u64 down = input_down[w], went_down = input_went_down[w], went_up = input_went_up[w];
+        input_states[pressed][w] = went_down;
+        input_states[held][w] = down & ~went_down;
+        input_states[released][w] = (went_up & ~down & ~went_down) | input_release_pending[w];
+        input_release_pending[w] = went_down & went_up & ~down;
     }
-    return false;
-}
-bool ik_compare_i32(void* a, void* b)
-{
-    i32 _a = *(i32*)a;
-    i32 _b = *(i32*)b;
 
-	return _a > _b;
+    // cleared afterwards, events seen between two updates belong to the next one
+    memset(input_went_down, 0, sizeof(input_went_down));
+    memset(input_went_up, 0, sizeof(input_went_up));
 }
-bool ik_compare_u32(void* a, void* b)
-{
-	u32 _a = *(u32*)a;
-	u32 _b = *(u32*)b;
 
-	return _a > _b;
+bool ik_poll_input_event(ik_input_event* out) {
+    if (input_queue_tail == input_queue_head) return false;
+    if (out) *out = input_queue[input_queue_tail & (INPUT_QUEUE_SIZE - 1)];
+    input_queue_tail++;
+    return true;
 }
-bool ik_compare_i64(void* a, void* b)
-{
-	i64 _a = *(i64*)a;
-	i64 _b = *(i64*)b;
 
-	return _a > _b;
+bool ik_get_key_state(u8 key, ik_key_state state) {
+    if ((u32)state > released) return false;
+    return input_bit(input_states[state], key);
 }
-bool ik_compare_u64(void* a, void* b)
-{
-	u64 _a = *(u64*)a;
-	u64 _b = *(u64*)b;
 
-	return _a > _b;
+bool ik_set_input_thread(bool enabled) {
+#ifdef _WIN32
+    return false;
+#else
+    if (!enabled)
+    {
+        input_thread_join();
+        return false;
+    }
+    if (input_thread_running) return true;
+    if (INPUT_TYPE != keyboardhit) return false;
+    if (pipe(input_thread_stop) != 0 || pipe(input_thread_wake) != 0)
+    {
+        input_thread_close_pipes();
+        return false;
+    }
+    // a full wake pipe already wakes ik_wait(), the thread must never block on it
+    fcntl(input_thread_wake[0], F_SETFL, fcntl(input_thread_wake[0], F_GETFL) | O_NONBLOCK);
+    fcntl(input_thread_wake[1], F_SETFL, fcntl(input_thread_wake[1], F_GETFL) | O_NONBLOCK);
+
+    input_thread_move_held = false;
+    input_thread_move_sent = false;
+    memcpy(input_thread_sent_down, input_term_down, sizeof(input_term_down));
+    memset(input_thread_missed, 0, sizeof(input_thread_missed));
+    input_thread_overflow = false;
+
+    // set before the thread starts, so its first events already go through the queue
+    input_thread_running = true;
+    if (pthread_create(&input_thread, 0, input_thread_main, 0) != 0)
+    {
+        input_thread_running = false;
+        input_thread_close_pipes();
+        return false;
+    }
+    return true;
+#endif
 }
-bool ik_compare_f32(void* a, void* b)
-{
-	float _a = *(float*)a;
-	float _b = *(float*)b;
 
-	return _a > _b;
+bool ik_set_mouse_input(bool enabled) {
+#ifdef _WIN32
+    return false;
+#else
+    if (enabled == input_mouse) return input_mouse;
+    if (enabled && !input_raw) return false;
+
+    // the switch must not land inside a frame that is still being written
+    if (screen_fd >= 0) screen_flush_until(ik_time_now_us() + 1000000);
+    input_mouse_report(enabled);
+    input_mouse = enabled;
+    return input_mouse;
+#endif
 }
-bool ik_compare_f64(void* a, void* b)
-{
-	double _a = *(double*)a;
-	double _b = *(double*)b;
 
-	return _a > _b;
+void ik_get_mouse_position(u8* x, u8* y) {
+    if (x) *x = input_mouse_x;
+    if (y) *y = input_mouse_y;
 }
-bool ik_compare_byte(void* a, void* b)
-{
-	byte _a = *(byte*)a;
-	byte _b = *(byte*)b;
 
-	return _a > _b;
+bool ik_input_record(const char* path, u32 seed) {
+    ik_input_stop();
+    input_record_file = fopen(path, "wb");
+    if (!input_record_file) return false;
+
+    static bool stop_at_exit = false;
+    if (!stop_at_exit) atexit(ik_input_stop);
+    stop_at_exit = true;
+
+    fwrite(INPUT_RECORD_MAGIC, 1, 4, input_record_file);
+    fputc(INPUT_RECORD_VERSION, input_record_file);
+    input_file_put(seed);
+    fflush(input_record_file);
+    input_tick = input_file_tick = 0;
+    input_file_start = ik_time_now_us();
+    input_file_time = 0;
+    input_record_from = input_update_end = input_queue_head;
+    input_sync_set = false;
+    return true;
 }
 
-#pragma endregion
-
-#pragma region Screen
-u8 SCREEN_WIDTH, SCREEN_HEIGHT = 0; 
-char SCREEN_BACKGROUND = ' ';
-ik_array SCREEN_BUFFER = {};
-bool SCREEN_UPDATE = false;
-int TICKRATE = 0;
+bool ik_input_replay(const char* path, u32* seed) {
+    ik_input_stop();
+    input_replay_file = fopen(path, "rb");
+    if (!input_replay_file) return false;
 
-//helper functions
-ik_string *GET_PIXEL(int x, int y) {
-    return (ik_string*)ik_array_get(&SCREEN_BUFFER, y * SCREEN_WIDTH + x);
+    char magic[4];
+    u64 recorded_seed;
+    if (fread(magic, 1, 4, input_replay_file) != 4 || memcmp(magic, INPUT_RECORD_MAGIC, 4) != 0
+        || fgetc(input_replay_file) != INPUT_RECORD_VERSION || !input_file_get(&recorded_seed))
+    {
+        ik_input_stop();
+        return false;
+    }
+    if (seed) *seed = (u32)recorded_seed;
+    input_tick = input_file_tick = 0;
+    input_file_start = ik_time_now_us();
+    input_file_time = 0;
+    input_replay_over = false;
+    input_replay_read_ahead();
+    return true;
 }
-//end !helper functions
 
+bool ik_input_replay_done() {
+    return !input_replay_file || input_replay_over;
+}
 
-void ik_screen_init(u8 width, u8 height, char background, int max_tick_rate){
-    SCREEN_WIDTH = width;
-    SCREEN_HEIGHT = height;
-    SCREEN_BACKGROUND = background;
-    TICKRATE = max_tick_rate;
-    ik_array_make(&SCREEN_BUFFER, 2 * sizeof(u64), height * width);
-    ik_string curr = { };
-    for (size_t i = 0; i < height * width; i++)
+bool ik_input_sync(u32 state_hash) {
+    if (input_record_file)
     {
-        ik_string_make_empty(&curr, 1);
-        ik_string_set_at(&curr, 0, SCREEN_BACKGROUND);
-        ik_array_append(&SCREEN_BUFFER, &curr);
+        input_sync_set = true;
+        input_sync_hash = state_hash;
     }
-    ik_clrscr();
-    printf("\n");
-    SCREEN_UPDATE = true;
+    else if (input_replay_file && input_sync_set) return input_sync_hash == state_hash;
+    return true;
 }
 
-void ik_screen_set_pixels(ik_array pixels){
-
-    for (size_t i = 0; i < pixels.size; i++)
+void ik_input_stop() {
+    if (input_record_file)
     {
-        pixel *_curr = (pixel*)ik_array_get(&pixels, i);
-        ik_screen_set_pixel(_curr->_x, _curr->_y, _curr->_char, _curr->_foreground, _curr->_background);
+        input_record_flush(INPUT_RECORD_END);
+        fclose(input_record_file);
+        input_record_file = 0;
+    }
+    if (input_replay_file)
+    {
+        fclose(input_replay_file);
+        input_replay_file = 0;
     }
 }
 
-void ik_screen_set_pixel(u8 x, u8 y, char to, color foreground, color background){
-    if(x < 0 || x >= SCREEN_WIDTH) return;
-    if(y < 0 || y >= SCREEN_HEIGHT) return;
+#define WAIT_MAX_FDS 16
 
-    int fore = (int)foreground;
-    int back = (int)background;
-    char formatted[14];
-    //format the string
-    
+int wait_fds[WAIT_MAX_FDS];
+u32 wait_fd_count = 0;
 
-    formatted[0] = '<'; formatted[3] = '<'; formatted[7] = '<'; formatted[10] = '<';
-    formatted[2] = '>'; formatted[5] = '>'; formatted[9] = '>'; formatted[12] = '>';
-    formatted[1] = (char)(fore + 97); formatted[8] = (char)(97) ;
-    formatted[4] = (char)(back + 65); formatted[11] = (char)(65) ;
-    formatted[6] = to;
-    formatted[13] = '\0';
-    ik_string *ref = GET_PIXEL(x, y);
-    //if(ref->cstring[0] != SCREEN_BACKGROUND)
-    ik_string_replace_index(ref, 0, ref->size - 1, (char*)formatted);
-}
-clock_t tick_t;
-void ik_screen_print(){
-    tick_t = clock();
-    SCREEN_UPDATE = false;
-    ik_cursor_hide();
-    //ik_clrscr();
-    ik_move_cursor_up(SCREEN_HEIGHT);
-    void* arr = (void*)SCREEN_BUFFER.data;
-    fflush(stdout);
-    for (size_t y = 0; y < SCREEN_HEIGHT; y++)
+ik_wait_result ik_wait(int* ready_fd) {
+    screen_wait_driven = true;
+    if (ready_fd) *ready_fd = -1;
+
+    while (true)
     {
-        for (size_t x = 0; x < SCREEN_WIDTH; x++)
+        i64 now = ik_time_now_us();
+        if (!SCREEN_UPDATE && now >= screen_deadline)
+        {
+            SCREEN_UPDATE = true;
+            screen_frame_start = now;
+        }
+        if (SCREEN_UPDATE) return wait_frame;
+        i64 wake = screen_deadline;
+
+#ifdef _WIN32
+        ik_sleep((wake - now + 999) / 1000);
+#else
+        struct pollfd fds[3 + WAIT_MAX_FDS];
+        u32 count = 0;
+        int input_fd = -1;
+        if (input_thread_running)
+        {
+            // empty the wake pipe before looking at the queue, an event queued after the look writes it again
+            u8 drain[64];
+            while (read(input_thread_wake[0], drain, sizeof(drain)) > 0) {}
+            if (input_thread_head.load(std::memory_order_acquire) != input_thread_tail.load(std::memory_order_relaxed))
+                return wait_input;
+            input_fd = input_thread_wake[0];
+        }
+        else if (INPUT_TYPE == keyboardhit && input_raw)
+        {
+            // releases of held keys and the end of a lone escape are input as well
+            u32 queued = input_queue_head;
+            i64 release = input_release_expired(now);
+            if (input_queue_head != queued) return wait_input;
+            if (release >= 0 && release < wake) wake = release;
+            if (input_ring_head != input_ring_tail)
+            {
+                i64 escape = input_last_read + INPUT_ESCAPE_US;
+                if (now >= escape) return wait_input;
+                if (escape < wake) wake = escape;
+            }
+            if (!input_terminal_closed) input_fd = STDIN_FILENO;
+        }
+        if (input_fd >= 0) fds[count++] = { input_fd, POLLIN, 0 };
+
+        bool output = screen_fd >= 0 && screen_pending.size != 0;
+        if (output) fds[count++] = { screen_fd, POLLOUT, 0 };
+        u32 first_user = count;
+        for (u32 i = 0; i < wait_fd_count; i++)
+        {
+            fds[count++] = { wait_fds[i], POLLIN, 0 };
+        }
+
+        if (poll(fds, count, (int)((wake - now + 999) / 1000)) <= 0) continue;
+
+        for (u32 i = first_user; i < count; i++)
+        {
+            if (fds[i].revents == 0) continue;
+            if (ready_fd) *ready_fd = fds[i].fd;
+            return wait_fd;
+        }
+        if (output && fds[first_user - 1].revents != 0) screen_flush_pending();
+        if (input_fd >= 0 && fds[0].revents != 0)
         {
-            ik_string *_this = GET_PIXEL(x, y);
-            ik_print_string(_this, reserve_space_options::dont_reserve, 1, align_options::align_left);
+            // a closed terminal keeps polling readable, stop watching it
+            if (!input_thread_running && (fds[0].revents & (POLLHUP | POLLERR | POLLNVAL))) input_terminal_closed = true;
+            return wait_input;
         }
-        ik_move_cursor_down(1);
-        ik_move_cursor_left(SCREEN_WIDTH);
-        //fflush(stdout);
+#endif
     }
-    ik_cursor_show();
-    tick_t = clock() - tick_t;
-    double time_taken = ((double)tick_t) / CLOCKS_PER_SEC;
-    ik_sleep((1000/TICKRATE) - time_taken * 1000);
-    SCREEN_UPDATE = true;
-    fflush(stdout);
 }
-void ik_screen_clear_screen(){
-    for (size_t y = 0; y < SCREEN_HEIGHT; y++)
+
+bool ik_wait_add_fd(int fd) {
+#ifdef _WIN32
+    return false;
+#else
+    if (fd < 0 || wait_fd_count == WAIT_MAX_FDS) return false;
+    for (u32 i = 0; i < wait_fd_count; i++)
     {
-        for (size_t x = 0; x < SCREEN_WIDTH; x++)
-        {
-            ik_string *curr = GET_PIXEL(x, y);
-            ik_string _new = { };
-            ik_string_make_empty(&_new, 1);
-            ik_string_set_at(&_new, 0, SCREEN_BACKGROUND);
-            ik_string_set(curr, &_new);
-        }        
+        if (wait_fds[i] == fd) return false;
     }
+    wait_fds[wait_fd_count++] = fd;
+    return true;
+#endif
 }
 
+void ik_wait_remove_fd(int fd) {
+    for (u32 i = 0; i < wait_fd_count; i++)
+    {
+        if (wait_fds[i] != fd) continue;
+        wait_fds[i] = wait_fds[--wait_fd_count];
+        return;
+    }
+}
 
 #pragma endregion
 
-#pragma region Sleep
+#pragma region Line Editor
 
-void ik_sleep(i64 milliseconds)
-{
-    if (milliseconds < 0) return;
-#ifdef _WIN32
-	Sleep(milliseconds);
-#else
-	usleep(milliseconds * 1000);
-#endif
+#define LINE_EDITOR_HISTORY 64
+
+//checks if a typed character can be part of a line of the given type
+bool line_editor_accepts(type_options type, u32 ch) {
+    if (type == _string) return ch >= 0x20 && ch != 0x7F;
+    if (ch >= '0' && ch <= '9') return true;
+    return type == _float && (ch == '.' || ch == ',');
 }
 
-#pragma endregion
+//the line as a UTF-8 ik_string
+void line_editor_string(ik_line_editor* editor, ik_string* out) {
+    char* buffer = (char*)ik_alloc(alloc_input, editor->text.size * 4 + 1);
+    if (!buffer) return;
+    u32 len = 0;
+    u32* text = (u32*)editor->text.data;
+    for (u64 i = 0; i < editor->text.size; i++)
+    {
+        len += utf8_encode(text[i], buffer + len);
+    }
+    buffer[len] = '\0';
+    ik_string_make(out, buffer);
+    ik_free(alloc_input, buffer, editor->text.size * 4 + 1);
+}
 
-#pragma region Input
+//replaces the line with a UTF-8 string, the cursor goes to its end
+void line_editor_load(ik_line_editor* editor, const char* utf8) {
+    editor->text.size = 0;
+    while (utf8 && *utf8 && editor->text.size < editor->max_len)
+    {
+        u32 len = 0;
+        u32 cp = utf8_decode(utf8, &len);
+        ik_array_append(&editor->text, &cp);
+        utf8 += len;
+    }
+    editor->cursor = (u32)editor->text.size;
+}
 
-ik_input_type INPUT_TYPE = stream;
-ik_array input_events;
+bool line_editor_valid(ik_line_editor* editor) {
+    if (editor->type == _string) return true;
+    if (editor->text.size == 0) return false;
 
-void ik_init_input() {
-    input_events = { };
-    ik_array_make(&input_events, 3 * sizeof(bool), 25); 
-    ik_input a = { };
-    ik_array_append(&input_events, &a);
-    for (size_t i = 0; i <= 25; i++)
+    ik_string line = { };
+    line_editor_string(editor, &line);
+    bool valid = editor->type == _int ? ik_is_int(line.cstring) : ik_is_numeric(line.cstring);
+    ik_string_destroy(&line);
+    return valid;
+}
+
+//the columns the characters from begin to end take
+u32 line_editor_columns(ik_line_editor* editor, u32 begin, u32 end) {
+    u32 columns = 0;
+    for (u32 i = begin; i < end; i++)
     {
-        a = { false, false, false };
-        ik_array_append(&input_events, &a);
+        columns += utf8_width(((u32*)editor->text.data)[i]);
     }
+    return columns;
 }
-void ik_set_input_type(ik_input_type type) {
-    INPUT_TYPE = type;
+
+void ik_line_editor_make(ik_line_editor* editor, u32 max_len, type_options type) {
+    array_make(&editor->text, sizeof(u32), max_len + 1, 0, alloc_input);
+    array_make(&editor->history, sizeof(ik_string), 8, 0, alloc_input);
+    editor->cursor = 0;
+    editor->scroll = 0;
+    editor->history_index = -1;
+    editor->max_len = max_len;
+    editor->type = type;
 }
 
-void ik_update_input() {
-    if (INPUT_TYPE != keyboardhit) return;
+void ik_line_editor_destroy(ik_line_editor* editor) {
+    for (u64 i = 0; i < editor->history.size; i++)
+    {
+        ik_string_destroy((ik_string*)editor->history.data + i);
+    }
+    ik_array_destroy(&editor->history);
+    ik_array_destroy(&editor->text);
+}
+
+bool ik_line_editor_feed(ik_line_editor* editor, const ik_input_event* event, ik_string* out, int* return_code) {
+    if (return_code) *return_code = 0;
+    if (event->_type != key_down && event->_type != key_repeat) return false;
 
-    for (size_t ch = 0; ch <= 25; ch++)
+    u32 size = (u32)editor->text.size;
+    switch (event->_key)
     {
-        ik_input* p = (ik_input*)ik_array_get(&input_events, ch);
-        if (GetAsyncKeyState(ch + 65))
+        case IK_KEY_LEFT:
+            if (editor->cursor > 0) editor->cursor--;
+            return false;
+        case IK_KEY_RIGHT:
+            if (editor->cursor < size) editor->cursor++;
+            return false;
+        case IK_KEY_HOME:
+            editor->cursor = 0;
+            return false;
+        case IK_KEY_END:
+            editor->cursor = size;
+            return false;
+        case IK_KEY_BACKSPACE:
+            if (editor->cursor == 0) return false;
+            ik_array_remove(&editor->text, --editor->cursor);
+            return false;
+        case IK_KEY_DELETE:
+            if (editor->cursor < size) ik_array_remove(&editor->text, editor->cursor);
+            return false;
+        case IK_KEY_ESCAPE:
+            editor->text.size = 0;
+            editor->cursor = 0;
+            editor->history_index = -1;
+            return false;
+        case IK_KEY_UP:
+        case IK_KEY_DOWN:
         {
-
-            if (p->pressed && !p->held) { //is pressed
-                p->pressed = false;
-                p->held = true;
-                p->released = false;
+            i32 count = (i32)editor->history.size;
+            if (count == 0) return false;
+            i32 index = editor->history_index;
+            if (event->_key == IK_KEY_UP) index = index < 0 ? count - 1 : ik_max(index - 1, 0);
+            else if (index >= 0) index = index + 1 < count ? index + 1 : -1;
+            if (index == editor->history_index) return false;
+
+            editor->history_index = index;
+            line_editor_load(editor, index < 0 ? 0 : ((ik_string*)editor->history.data)[index].cstring);
+            return false;
+        }
+        case IK_KEY_ENTER:
+        {
+            if (!line_editor_valid(editor))
+            {
+                if (return_code) *return_code = 3;
+                return false;
             }
-            else if (!p->pressed && !p->held) { //is held
-                p->pressed = true;
-                p->held = false;
-                p->released = false;
+            line_editor_string(editor, out);
+
+            // the history keeps each line once in a row and forgets the oldest
+            ik_string* last = editor->history.size ? (ik_string*)editor->history.data + editor->history.size - 1 : 0;
+            if (out->size > 0 && (!last || strcmp(last->cstring, out->cstring) != 0))
+            {
+                if (editor->history.size == LINE_EDITOR_HISTORY)
+                {
+                    ik_string_destroy((ik_string*)editor->history.data);
+                    ik_array_remove(&editor->history, 0);
+                }
+                ik_string copy = { };
+                ik_string_make(&copy, out->cstring);
+                ik_array_append(&editor->history, &copy);
             }
+            editor->text.size = 0;
+            editor->cursor = 0;
+            editor->scroll = 0;
+            editor->history_index = -1;
+            if (return_code) *return_code = 1;
+            return true;
         }
-        else if (p->held || p->pressed) {
-            p->pressed = false;
-            p->held = false;
-            p->released = true;
-        }
-        else if (p->released) {
-            p->pressed = false;
-            p->held = false;
-            p->released = false;
-        }
-        // if (p->pressed) printf("\n[%c]: Pressed.              ", ch + 65);
-        // else if (p->held) printf("\n[%c]: Held.               ", ch + 65);
-        // else if (p->released) printf("\n[%c]: Released.       ", ch + 65);
-        // else printf("\n[%c]:                                  ", ch + 65);
+        default:
+            break;
+    }
+
+    u32 ch = event->_char;
+    if (ch == 0 || !line_editor_accepts(editor->type, ch)) return false;
+    if (size >= editor->max_len)
+    {
+        if (return_code) *return_code = 2;
+        return false;
     }
+
+    ik_array_insert(&editor->text, editor->cursor++, &ch);
+    return false;
 }
 
-bool ik_get_key_state(char ch, ik_key_state state) {
-    ik_input* p = (ik_input*)ik_array_get(&input_events, ch - 65);
+void ik_line_editor_draw(ik_line_editor* editor, u8 x, u8 y, u8 width, ik_color foreground, ik_color background) {
+    if (width == 0 || y >= SCREEN_HEIGHT) return;
+    u32* text = (u32*)editor->text.data;
 
-    switch (state)
+    // scroll so the cursor cell fits, at the end of the line the cursor sits on the cell after it.
+    // Scrolling back happens once the rest of the line fits, e.g. after a shorter history line
+    if (editor->cursor < editor->scroll) editor->scroll = editor->cursor;
+    while (editor->scroll < editor->cursor && line_editor_columns(editor, editor->scroll, editor->cursor) + 1 > width)
     {
-        case pressed:
-            return p->pressed;
-        case held:
-            return p->held;
-        case released:
-            return p->released;
-        default:
-            break;
+        editor->scroll++;
+    }
+    while (editor->scroll > 0 && line_editor_columns(editor, editor->scroll - 1, (u32)editor->text.size) + 1 <= width)
+    {
+        editor->scroll--;
     }
-}
 
-#pragma endregion
+    // the cursor swaps the colors, a default color becomes a visible one
+    ik_color cursor_fore = background == none ? (ik_color)black : background;
+    ik_color cursor_back = foreground == none ? (ik_color)light_gray : foreground;
+
+    u32 end = (u32)ik_min((i64)x + width, SCREEN_WIDTH);
+    u32 column = x;
+    for (u32 i = editor->scroll; column < end; i++)
+    {
+        bool cursor = i == editor->cursor;
+        ik_color fore = cursor ? cursor_fore : foreground;
+        ik_color back = cursor ? cursor_back : background;
+        if (i >= editor->text.size)
+        {
+            ik_screen_set_pixel((u8)column++, y, ' ', fore, back);
+            continue;
+        }
+
+        char utf8[5] = { };
+        utf8_encode(text[i], utf8);
+        u16 glyph = ik_glyph_intern(utf8);
+        // a wide character that would stick out of the region leaves it blank
+        if (column + ik_glyph_width(glyph) > end)
+        {
+            ik_screen_set_pixel((u8)column++, y, ' ', foreground, background);
+            continue;
+        }
+        ik_screen_set_glyph((u8)column, y, glyph, fore, back);
+        column += ik_glyph_width(glyph);
+    }
+}
 
+#pragma endregion
\ No newline at end of file
@@ -0,0 +1,360 @@
+#ifndef __IK_ARRAY_H__
+#define __IK_ARRAY_H__
+
+#pragma region External Includes
+#include "ik_lib.h"
+#include <new>
+#include <utility>
+#include <algorithm>
+#include <type_traits>
+#pragma endregion
+
+// ik::array<T> is an ik_array with the element type known at compile time. It is an ik_array, so it
+// can be handed to every ik_array function, but element access, iteration, predicates and comparators
+// are templates the compiler can inline instead of going through void* and function pointers.
+// The C functions copy raw bytes, only use them on trivially copyable types. Setting arena before the
+// first element is added makes it draw from an ik_arena, setting subsystem picks the allocator it
+// uses otherwise.
+
+namespace ik
+{
+
+#pragma region Functors
+
+/**
+ * @brief the default comparator, like the ik_compare functions it returns true if a is greater than b
+ */
+template<typename T>
+struct greater
+{
+    bool operator()(const T& a, const T& b) const { return a > b; }
+};
+
+/**
+ * @brief a predicate matching elements equal to a value
+ */
+template<typename T>
+struct equal_to
+{
+    const T& value;
+    bool operator()(const T& element) const { return element == value; }
+};
+
+#pragma endregion
+
+#pragma region Array
+
+template<typename T>
+struct array : ik_array
+{
+    // trivially copyable elements can be moved by realloc and memmove, others are moved one by one
+    static constexpr bool trivial = std::is_trivially_copyable_v<T>;
+
+    array() : ik_array{ 0, sizeof(T), 0, 0, 0, alloc_array } {}
+
+    /**
+     * @brief creates an empty array with room for a number of elements
+     * @param[in] capacity the number of elements to preallocate
+     */
+    explicit array(u64 capacity) : array() { reserve(capacity); }
+
+    array(const array&) = delete;
+    array& operator=(const array&) = delete;
+
+    array(array&& other) : ik_array(other) { other.release(); }
+
+    array& operator=(array&& other)
+    {
+        if (this != &other)
+        {
+            destroy();
+            ik_array::operator=(other);
+            other.release();
+        }
+        return *this;
+    }
+
+    ~array() { destroy(); }
+
+    /**
+     * @brief takes over the memory of an array made with ik_array_make(), which is left empty
+     * @param[in,out] other the array, its stride has to be sizeof(T)
+     * @returns false if the stride does not match
+     */
+    bool adopt(ik_array* other)
+    {
+        if (other->stride != sizeof(T)) return false;
+
+        destroy();
+        ik_array::operator=(*other);
+        *other = { 0, other->stride, 0, 0, 0, other->subsystem };
+        return true;
+    }
+
+    T* begin() { return (T*)data; }
+    T* end() { return (T*)data + size; }
+    const T* begin() const { return (const T*)data; }
+    const T* end() const { return (const T*)data + size; }
+
+    T& operator[](u64 i) { return ((T*)data)[i]; }
+    const T& operator[](u64 i) const { return ((const T*)data)[i]; }
+    T& front() { return ((T*)data)[0]; }
+    T& back() { return ((T*)data)[size - 1]; }
+
+    bool empty() const { return size == 0; }
+
+    /**
+     * @brief makes sure the array can hold a number of elements without reallocating
+     * @param[in] count the number of elements
+     * @returns false if the memory could not be allocated
+     * @note pointers into the array are invalid afterwards if it had to grow
+     */
+    bool reserve(u64 count)
+    {
+        if (count <= capacity) return true;
+        if constexpr (trivial)
+        {
+            return ik_array_reserve(this, count);
+        }
+        else
+        {
+            T* moved = (T*)(arena ? ik_arena_alloc(arena, count * sizeof(T)) : ik_alloc(subsystem, count * sizeof(T)));
+            if (!moved) return false;
+
+            for (u64 i = 0; i < size; i++)
+            {
+                new (moved + i) T(std::move(begin()[i]));
+                begin()[i].~T();
+            }
+            if (!arena) ik_free(subsystem, data, capacity * sizeof(T));
+            data = moved;
+            capacity = count;
+            return true;
+        }
+    }
+
+    /**
+     * @brief sets the number of elements, new elements are value-initialized
+     * @param[in] count the new number of elements
+     * @returns false if the memory could not be allocated
+     */
+    bool resize(u64 count)
+    {
+        if (!reserve(count)) return false;
+
+        while (size > count) pop();
+        for (; size < count; size++)
+        {
+            new (end()) T();
+        }
+        return true;
+    }
+
+    void clear()
+    {
+        if constexpr (!std::is_trivially_destructible_v<T>)
+        {
+            for (T& element : *this) element.~T();
+        }
+        size = 0;
+    }
+
+    /**
+     * @brief constructs an element at the end of the array
+     * @param[in] args the arguments for the constructor of T
+     * @returns the new element
+     * @note the capacity doubles when it runs out, like ik_array_append(). Aborts if that fails.
+     */
+    template<typename... Args>
+    T& emplace(Args&&... args)
+    {
+        if (size < capacity)
+        {
+            return *new (begin() + size++) T(std::forward<Args>(args)...);
+        }
+
+        // the arguments may point into the array, so the element is made before it moves
+        T element(std::forward<Args>(args)...);
+        if (!reserve(capacity ? capacity * 2 : 8))
+        {
+            abort();
+        }
+        return *new (begin() + size++) T(std::move(element));
+    }
+
+    T& push(const T& element) { return emplace(element); }
+    T& push(T&& element) { return emplace(std::move(element)); }
+
+    void pop()
+    {
+        size--;
+        end()->~T();
+    }
+
+    /**
+     * @brief inserts an element, the elements from index on move up one place
+     * @param[in] index where the element goes, size appends it
+     * @param[in] element the element
+     */
+    T& insert(u64 index, T element)
+    {
+        emplace(std::move(element));
+        std::rotate(begin() + index, end() - 1, end());
+        return begin()[index];
+    }
+
+    /**
+     * @brief removes an element, the elements after it move down one place
+     * @param[in] index the index of the element to be removed
+     * @note O(n) linear removal at worst. Use when order matters.
+     */
+    void remove(u64 index)
+    {
+        std::move(begin() + index + 1, end(), begin() + index);
+        pop();
+    }
+
+    /**
+     * @brief removes an element by moving the last one into its place
+     * @param[in] index the index of the element to be removed
+     * @note O(1) constant removal. Use when performance matters but order does not.
+     */
+    void remove_fast(u64 index)
+    {
+        if (index != size - 1)
+        {
+            begin()[index] = std::move(back());
+        }
+        pop();
+    }
+
+    /**
+     * @brief removes every element a predicate is true for, the rest keep their order
+     * @param[in] predicate called with an element, returns true to remove it
+     * @returns the number of removed elements
+     */
+    template<typename Predicate>
+    u64 erase_if(Predicate predicate)
+    {
+        T* kept = std::remove_if(begin(), end(), predicate);
+        u64 removed = end() - kept;
+        while (end() != kept) pop();
+        return removed;
+    }
+
+    /**
+     * @brief finds the first element a predicate is true for
+     * @param[in] predicate called with an element, returns true if it matches
+     * @returns the index of the element, -1 if there is none
+     */
+    template<typename Predicate>
+    i64 find_if(Predicate predicate) const
+    {
+        for (u64 i = 0; i < size; i++)
+        {
+            if (predicate(begin()[i])) return (i64)i;
+        }
+        return -1;
+    }
+
+    i64 find(const T& value) const { return find_if(equal_to<T>{ value }); }
+
+    /**
+     * @brief finds the first element of the sorted array that does not go before a value
+     * @param[in] value the value to look for
+     * @param[in] mode the order the array is sorted in
+     * @param[in] comparator returns true if a is greater than b, like the ik_compare functions
+     * @returns the index of the element, size if there is none
+     */
+    template<typename Comparator = greater<T>>
+    u64 lower_bound(const T& value, ik_array_sort_mode mode = asc, Comparator comparator = {}) const
+    {
+        if (mode == desc) return std::lower_bound(begin(), end(), value, comparator) - begin();
+        return std::lower_bound(begin(), end(), value, [&](const T& a, const T& b) { return comparator(b, a); }) - begin();
+    }
+
+    /**
+     * @brief finds the first element of the sorted array that goes after a value
+     * @param[in] value the value to look for
+     * @param[in] mode the order the array is sorted in
+     * @param[in] comparator returns true if a is greater than b, like the ik_compare functions
+     * @returns the index of the element, size if there is none
+     */
+    template<typename Comparator = greater<T>>
+    u64 upper_bound(const T& value, ik_array_sort_mode mode = asc, Comparator comparator = {}) const
+    {
+        if (mode == desc) return std::upper_bound(begin(), end(), value, comparator) - begin();
+        return std::upper_bound(begin(), end(), value, [&](const T& a, const T& b) { return comparator(b, a); }) - begin();
+    }
+
+    /**
+     * @brief finds an element equal to a value in the sorted array
+     * @returns the index of the first equal element, -1 if there is none
+     */
+    template<typename Comparator = greater<T>>
+    i64 binary_search(const T& value, ik_array_sort_mode mode = asc, Comparator comparator = {}) const
+    {
+        u64 index = lower_bound(value, mode, comparator);
+        if (index == size) return -1;
+
+        const T& found = begin()[index];
+        return (mode == desc ? comparator(value, found) : comparator(found, value)) ? -1 : (i64)index;
+    }
+
+    /**
+     * @brief inserts an element where it keeps the sorted array sorted, after equal elements
+     */
+    template<typename Comparator = greater<T>>
+    T& insert_sorted(T element, ik_array_sort_mode mode = asc, Comparator comparator = {})
+    {
+        u64 index = upper_bound(element, mode, comparator);
+        return insert(index, std::move(element));
+    }
+    bool contains(const T& value) const { return find(value) >= 0; }
+
+    /**
+     * @brief sorts the array, equal elements may change their order
+     * @param[in] mode is the mode of sorting (ascending or descending)
+     * @param[in] comparator returns true if a is greater than b, like the ik_compare functions
+     */
+    template<typename Comparator = greater<T>>
+    void sort(ik_array_sort_mode mode = asc, Comparator comparator = {})
+    {
+        if (mode == desc) std::sort(begin(), end(), comparator);
+        else std::sort(begin(), end(), [&](const T& a, const T& b) { return comparator(b, a); });
+    }
+
+    /**
+     * @brief sorts the array, equal elements keep their order
+     * @param[in] mode is the mode of sorting (ascending or descending)
+     * @param[in] comparator returns true if a is greater than b, like the ik_compare functions
+     */
+    template<typename Comparator = greater<T>>
+    void sort_stable(ik_array_sort_mode mode = asc, Comparator comparator = {})
+    {
+        if (mode == desc) std::stable_sort(begin(), end(), comparator);
+        else std::stable_sort(begin(), end(), [&](const T& a, const T& b) { return comparator(b, a); });
+    }
+
+private:
+    void destroy()
+    {
+        clear();
+        if (!arena && data) ik_free(subsystem, data, capacity * sizeof(T));
+        release();
+    }
+
+    void release()
+    {
+        data = 0;
+        size = 0;
+        capacity = 0;
+        arena = 0;
+    }
+};
+
+#pragma endregion
+
+} // namespace ik
+
+#endif //!__IK_ARRAY_H__
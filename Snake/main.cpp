@@ -1,4 +1,5 @@
 #include "ik_lib.h"
+#include "ik_array.h"
 #include <time.h>
 int x = 0;
 
@@ -25,32 +26,61 @@ typedef struct {
 	u8 x; u8 y;
 }coord;
 
-void init_snake(ik_array *snake);
+void init_snake(ik::array<snake_body> *snake);
 void update_direction();
 void update_snake();
 void grow_snake();
 void check_collisions();
 void fill_border();
 void update_valid_food_spawns();
+u32 state_hash();
+void finish_replay();
 
-ik_array snake;
+ik::array<snake_body> snake;
+ik_array turns; //directions typed but not taken yet, one is taken per tick
 int next_dir = 1;
 int score = 0;
 GAMESTATE state;
-ik_random random;
+ik_random rng;
 
 coord current_Food;
 
 ik_string GAME_OVER_TEXT = { };
 ik_string PRESS_Q_TO_EXIT = { };
 ik_string SCORE = { };
+ik_arena frame_arena; //the temporaries of one frame
 clock_t t;
 
-int main() {
+// snake --record <file> plays normally and records the input, snake --replay <file>
+// plays a recording back headless and as fast as possible and reports how long it took
+bool replaying = false;
+u64 ticks = 0;
+u64 desyncs = 0;
+i64 replay_start = 0;
 
-	ik_random_init(&random, time(NULL));
+int main(int argc, char** argv) {
+
+	u32 seed = (u32)time(NULL);
+	if (argc == 3 && strcmp(argv[1], "--replay") == 0) {
+		if (!ik_input_replay(argv[2], &seed)) {
+			printf("can not replay %s\n", argv[2]);
+			return 1;
+		}
+		replaying = true;
+		ik_screen_set_headless(true);
+		replay_start = ik_time_now_us();
+	}
+	else if (argc == 3 && strcmp(argv[1], "--record") == 0) {
+		if (!ik_input_record(argv[2], seed)) {
+			printf("can not record to %s\n", argv[2]);
+			return 1;
+		}
+	}
+
+	ik_random_init(&rng, seed);
 	ik_string_make(&GAME_OVER_TEXT, "Game Over!");
 	ik_string_make(&PRESS_Q_TO_EXIT, "Press Q to exit!");
+	ik_arena_make(&frame_arena, 1024);
 	ik_screen_init(40, 20, ' ', 5);
 	ik_init_input();
 	ik_set_input_type(keyboardhit);
@@ -60,23 +90,26 @@ int main() {
 		fill_border();
 		t = clock();
 		if (SCREEN_UPDATE) {
-			ik_string_destroy(&SCORE);
-			ik_string_make(&SCORE, "Your Score: ");
+			ik_arena_reset(&frame_arena);
+			ik_string_make_arena(&SCORE, "Your Score: ", &frame_arena);
 			char scorechar[10];
 			sprintf(scorechar, "%i", score);
 			ik_string_append(&SCORE, scorechar);
 
 			check_collisions();
 			ik_update_input();
+			if (replaying && ik_input_replay_done()) finish_replay();
+			// the first tick sets everything up, the ones after it should not need to allocate
+			if (ticks++ == 0) ik_reset_alloc_stats();
+			if (!ik_input_sync(state_hash())) desyncs++;
 			if (state == PLAYING) {
 				update_direction();
 				update_snake();
 				if (state == GAMEOVER) continue;
 				ik_screen_set_pixel(current_Food.x, current_Food.y, '#', yellow, yellow);
-				for (size_t i = 0; i < snake.size; i++)
+				for (snake_body& part : snake)
 				{
-					snake_body* _curr = (snake_body*)ik_array_get(&snake, i);
-					ik_screen_set_pixel(_curr->x, _curr->y, '#', red, none);
+					ik_screen_set_pixel(part.x, part.y, '#', red, none);
 				}
 				for (size_t i = 0; i < SCORE.size; i++)
 				{
@@ -128,53 +161,64 @@ int main() {
 	
 }
 
-void init_snake(ik_array *snake) {
+void init_snake(ik::array<snake_body> *snake) {
 	current_Food = { };
-	ik_array_make(snake, 4 * sizeof(u8), 10);
+	snake->reserve(10);
+	ik_array_make(&turns, sizeof(u8), 4);
 	snake_body head = { 2, 1, SCREEN_WIDTH / 2, SCREEN_HEIGHT / 2 };
 	snake_body body = { 0, 1, SCREEN_WIDTH / 2 - 1, SCREEN_HEIGHT / 2 };
 	snake_body tail = { 1, 1, SCREEN_WIDTH / 2 - 2, SCREEN_HEIGHT / 2 };
-	ik_array_append(snake, &head);
-	ik_array_append(snake, &body);
-	ik_array_append(snake, &tail);
+	snake->push(head);
+	snake->push(body);
+	snake->push(tail);
 	update_valid_food_spawns();
 	state = PLAYING;
 }
 void update_direction() {
 	if (ik_get_key_state('T', pressed)) grow_snake();
 
-	if (ik_get_key_state('W', pressed) && next_dir != 2) next_dir = NORTH;
-	else if (ik_get_key_state('A', pressed) && next_dir != 1) next_dir = WEST;
-	else if (ik_get_key_state('S', pressed) && next_dir != 0) next_dir = SOUTH;
-	else if (ik_get_key_state('D', pressed) && next_dir != 3) next_dir = EAST;
+	// every press counts, even two within one tick
+	ik_input_event e;
+	while (ik_poll_input_event(&e)) {
+		if (e._type != key_down || turns.size >= 3) continue;
+		u8 dir;
+		if (e._key == 'W') dir = NORTH;
+		else if (e._key == 'A') dir = WEST;
+		else if (e._key == 'S') dir = SOUTH;
+		else if (e._key == 'D') dir = EAST;
+		else continue;
+		ik_array_append(&turns, &dir);
+	}
+
+	while (turns.size > 0) {
+		u8 dir = *(u8*)ik_array_get(&turns, 0);
+		ik_array_remove(&turns, 0);
+		if (dir != next_dir && dir != (next_dir + 2) % 4) {
+			next_dir = dir;
+			break;
+		}
+	}
 }
 void update_snake() {
-	for (i32 i = snake.size - 1; i >= 0; i--)
+	// the head is first, every other part takes the direction of the one in front of it
+	for (size_t i = snake.size - 1; i > 0; i--)
 	{
-		snake_body* _curr = (snake_body*)ik_array_get(&snake, i);
-		snake_body* _next = (snake_body*)ik_array_get(&snake, ik_max(i - 1, 0));
-		
-		if (_curr->type == TAIL) { //tail
-			_curr->dir = _next->dir;
-		}
-		else if (_curr->type == BODY) { //body
-			_curr->dir = _next->dir;
-		}
-		if (_curr->type == HEAD) { //head
-			_curr->dir = next_dir;
-		}
-		if (_curr->dir == NORTH) _curr->y--;
-		else if (_curr->dir == EAST) _curr->x++;
-		else if (_curr->dir == SOUTH) _curr->y++;
-		else if (_curr->dir == WEST) _curr->x--;
-		
+		snake[i].dir = snake[i - 1].dir;
+	}
+	snake[0].dir = next_dir;
+
+	for (snake_body& part : snake)
+	{
+		if (part.dir == NORTH) part.y--;
+		else if (part.dir == EAST) part.x++;
+		else if (part.dir == SOUTH) part.y++;
+		else if (part.dir == WEST) part.x--;
 	}
 }
 void grow_snake() {
 	score += 100;
-	snake_body* old_tail;
+	snake_body* old_tail = &snake.back();
 	snake_body new_tail = { };
-	old_tail = (snake_body*)ik_array_get(&snake, snake.size - 1);
 
 	new_tail.dir = old_tail->dir;
 	new_tail.type = TAIL;
@@ -195,22 +239,21 @@ void grow_snake() {
 		new_tail.y = old_tail->y;
 		new_tail.x = old_tail->x + 1;
 	}
-	ik_array_append(&snake, &new_tail);
+	snake.push(new_tail);
 }
 void check_collisions() {
-	snake_body *head;
-	head = (snake_body*)ik_array_get(&snake, 0);
+	// a copy, growing the snake may move it
+	snake_body head = snake[0];
 
 	for (size_t i = 1; i < snake.size; i++)
 	{
-		snake_body* _curr;
-		_curr = (snake_body*)ik_array_get(&snake, i);
+		const snake_body& _curr = snake[i];
 
-		if ((head->x == _curr->x && _curr->y == head->y) || (head->x == SCREEN_WIDTH - 1 || head->x == 0 || head->y == SCREEN_HEIGHT - 2 || head->y == 0)) {
+		if ((head.x == _curr.x && _curr.y == head.y) || (head.x == SCREEN_WIDTH - 1 || head.x == 0 || head.y == SCREEN_HEIGHT - 2 || head.y == 0)) {
 			state = GAMEOVER;
 			return;
 		}
-		if (head->x == current_Food.x && head->y == current_Food.y) {
+		if (head.x == current_Food.x && head.y == current_Food.y) {
 			current_Food = { };
 			update_valid_food_spawns();
 			grow_snake();
@@ -230,6 +273,15 @@ void fill_border() {
 	}
 }
 void update_valid_food_spawns() {
+	// every cell inside the border the snake does not cover
+	ik_hashset occupied = { };
+	ik_hashset_make(&occupied, sizeof(coord), snake.size, 0, 0);
+	for (const snake_body& part : snake)
+	{
+		coord cell = { part.x, part.y };
+		ik_hashset_insert(&occupied, &cell);
+	}
+
 	ik_array valid_spots = { };
 	ik_array_make(&valid_spots, 2 * sizeof(u8), 30);
 	
@@ -237,19 +289,15 @@ void update_valid_food_spawns() {
 	{
 		for (size_t y = 1; y < SCREEN_HEIGHT - 2; y++)
 		{
-			for (size_t i = 0; i < snake.size; i++)
-			{
-				snake_body* _curr;
-				_curr = (snake_body*)ik_array_get(&snake, i);
-				if (x != _curr->x && y != _curr->y) {
-					coord valid = { x ,y };
-					ik_array_append(&valid_spots, &valid);
-				}
+			coord valid = { (u8)x, (u8)y };
+			if (!ik_hashset_contains(&occupied, &valid)) {
+				ik_array_append(&valid_spots, &valid);
 			}
 		}
 	}
+	ik_hashset_destroy(&occupied);
 	int index = 0;
-	ik_random_next(&random, &index);
+	ik_random_next(&rng, &index);
 	index %= valid_spots.size;
 	
 	coord* new_food = (coord*)ik_array_get(&valid_spots, index);
@@ -257,4 +305,25 @@ void update_valid_food_spawns() {
 	current_Food.y = new_food->y;
 
 	ik_array_destroy(&valid_spots);
+}
+u32 state_hash() {
+	// FNV-1a over everything the input drives
+	u32 hash = 2166136261u;
+	u8* bytes = (u8*)snake.data;
+	for (size_t i = 0; i < snake.size * snake.stride; i++) hash = (hash ^ bytes[i]) * 16777619u;
+	u32 values[] = { (u32)score, (u32)next_dir, (u32)state, current_Food.x, current_Food.y };
+	for (size_t i = 0; i < sizeof(values) / sizeof(values[0]); i++) hash = (hash ^ values[i]) * 16777619u;
+	return hash;
+}
+void finish_replay() {
+	i64 elapsed = ik_time_now_us() - replay_start;
+	printf("replayed %llu ticks in %.2f ms, %.1f us per tick\n", ticks, elapsed / 1000.0, ticks ? (double)elapsed / ticks : 0.0);
+	printf("score %i, %llu desynced ticks\n", score, desyncs);
+	u64 allocations = 0;
+	for (int i = 0; i < alloc_subsystem_count; i++) {
+		ik_alloc_stats stats = ik_get_alloc_stats((ik_alloc_subsystem)i);
+		allocations += stats.allocs + stats.reallocs;
+	}
+	printf("%llu allocations after the first tick\n", allocations);
+	exit(desyncs == 0 ? 0 : 2);
 }
\ No newline at end of file